@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""Generate multigroup reactor benchmark decks for xtrans.
+
+Every case is written to its own directory as an input deck plus the
+material id map (mid.txt) the deck refers to.  Cross sections are written in
+the multigroup MaterialProperties format ("sigma_t, group=1 to G",
+"sigma_s, material m", "ksi, group=1 to G", "nu_sigf, group=1 to G").
+
+Usage: python3 generate_decks.py [output_dir]
+"""
+
+import math
+import os
+import sys
+
+# ---------------------------------------------------------------------------
+# C5G7 7-group data (NEA/NSC/DOC(2003)16).  Scattering rows are g_in, columns
+# are g_out.
+# ---------------------------------------------------------------------------
+C5G7_CHI = [5.87910e-01, 4.11760e-01, 3.39060e-04, 1.17610e-07, 0.0, 0.0, 0.0]
+
+C5G7 = {
+    "uo2": {
+        "sigt": [1.77949e-01, 3.29805e-01, 4.80388e-01, 5.54367e-01,
+                 3.11801e-01, 3.95168e-01, 5.64406e-01],
+        "nusigf": [2.005998e-02, 2.027303e-03, 1.570599e-02, 4.518301e-02,
+                   4.334208e-02, 2.020901e-01, 5.257105e-01],
+        "sigs": [
+            [1.27537e-01, 4.23780e-02, 9.43740e-06, 5.51630e-09, 0.0, 0.0, 0.0],
+            [0.0, 3.24456e-01, 1.63140e-03, 3.14270e-09, 0.0, 0.0, 0.0],
+            [0.0, 0.0, 4.50940e-01, 2.67920e-03, 0.0, 0.0, 0.0],
+            [0.0, 0.0, 0.0, 4.52565e-01, 5.56640e-03, 0.0, 0.0],
+            [0.0, 0.0, 0.0, 1.25250e-04, 2.71401e-01, 1.02550e-02, 1.00210e-08],
+            [0.0, 0.0, 0.0, 0.0, 1.29680e-03, 2.65802e-01, 1.68090e-02],
+            [0.0, 0.0, 0.0, 0.0, 0.0, 8.54580e-03, 2.73080e-01]],
+    },
+    "mox43": {
+        "sigt": [1.78731e-01, 3.30849e-01, 4.83772e-01, 5.66922e-01,
+                 4.26227e-01, 6.78997e-01, 6.82852e-01],
+        "nusigf": [2.175300e-02, 2.535103e-03, 1.626799e-02, 6.547410e-02,
+                   3.072409e-02, 6.666510e-01, 7.139904e-01],
+        "sigs": [
+            [1.28876e-01, 4.14130e-02, 8.22900e-06, 5.04050e-09, 0.0, 0.0, 0.0],
+            [0.0, 3.25452e-01, 1.63950e-03, 1.59820e-09, 0.0, 0.0, 0.0],
+            [0.0, 0.0, 4.53188e-01, 2.61420e-03, 0.0, 0.0, 0.0],
+            [0.0, 0.0, 0.0, 4.57173e-01, 5.53940e-03, 0.0, 0.0],
+            [0.0, 0.0, 0.0, 1.60460e-04, 2.76814e-01, 9.31270e-03, 9.16560e-09],
+            [0.0, 0.0, 0.0, 0.0, 2.00510e-03, 2.52962e-01, 1.48500e-02],
+            [0.0, 0.0, 0.0, 0.0, 0.0, 8.49480e-03, 2.65007e-01]],
+    },
+    "guide_tube": {
+        "sigt": [1.26032e-01, 2.93160e-01, 2.84250e-01, 2.81020e-01,
+                 3.34460e-01, 5.65640e-01, 1.17214e+00],
+        "sigs": [
+            [6.61659e-02, 5.90700e-02, 2.83340e-04, 1.46220e-06, 2.06420e-08, 0.0, 0.0],
+            [0.0, 2.40377e-01, 5.24350e-02, 2.49900e-04, 1.92390e-05, 2.98750e-06, 4.21400e-07],
+            [0.0, 0.0, 1.83425e-01, 9.22880e-02, 6.93650e-03, 1.07900e-03, 2.05430e-04],
+            [0.0, 0.0, 0.0, 7.90769e-02, 1.69990e-01, 2.58600e-02, 4.92560e-03],
+            [0.0, 0.0, 0.0, 3.73400e-05, 9.97570e-02, 2.06790e-01, 2.44780e-02],
+            [0.0, 0.0, 0.0, 0.0, 9.17420e-04, 3.16774e-01, 2.38760e-01],
+            [0.0, 0.0, 0.0, 0.0, 0.0, 4.97930e-02, 1.09910e+00]],
+    },
+    "moderator": {
+        "sigt": [1.59206e-01, 4.12970e-01, 5.90310e-01, 5.84350e-01,
+                 7.18000e-01, 1.25445e+00, 2.65038e+00],
+        "sigs": [
+            [4.44777e-02, 1.13400e-01, 7.23470e-04, 3.74990e-06, 5.31840e-08, 0.0, 0.0],
+            [0.0, 2.82334e-01, 1.29940e-01, 6.23400e-04, 4.80020e-05, 7.44860e-06, 1.04550e-06],
+            [0.0, 0.0, 3.45256e-01, 2.24570e-01, 1.69990e-02, 2.64430e-03, 5.03440e-04],
+            [0.0, 0.0, 0.0, 9.10284e-02, 4.15510e-01, 6.37320e-02, 1.21390e-02],
+            [0.0, 0.0, 0.0, 7.14370e-05, 1.39138e-01, 5.11820e-01, 6.12290e-02],
+            [0.0, 0.0, 0.0, 0.0, 2.21570e-03, 6.99913e-01, 5.37320e-01],
+            [0.0, 0.0, 0.0, 0.0, 0.0, 1.32440e-01, 2.48070e+00]],
+    },
+}
+
+C5G7_PITCH = 1.26
+C5G7_PIN_RADIUS = 0.54
+C5G7_NPIN = 17
+# guide tube and central instrument tube positions in a 17x17 assembly
+C5G7_GUIDE_TUBES = set([
+    (2, 5), (2, 8), (2, 11), (3, 3), (3, 13), (5, 2), (5, 5), (5, 8),
+    (5, 11), (5, 14), (8, 2), (8, 5), (8, 8), (8, 11), (8, 14), (11, 2),
+    (11, 5), (11, 8), (11, 11), (11, 14), (13, 3), (13, 13), (14, 5),
+    (14, 8), (14, 11)])
+
+# ---------------------------------------------------------------------------
+# Takeda model 1 (small LWR) 2-group data
+# ---------------------------------------------------------------------------
+TAKEDA = {
+    "core": {
+        "sigt": [2.23775e-01, 1.03864e+00],
+        "nusigf": [9.09319e-03, 2.90183e-01],
+        "chi": [1.0, 0.0],
+        "sigs": [[1.92423e-01, 2.28253e-02], [0.0, 8.80439e-01]],
+    },
+    "reflector": {
+        "sigt": [2.50367e-01, 1.64482e+00],
+        "sigs": [[1.93446e-01, 5.65042e-02], [0.0, 1.62452e+00]],
+    },
+    "control_rod": {
+        "sigt": [8.52325e-02, 2.17460e-01],
+        "sigs": [[6.77241e-02, 6.45461e-05], [0.0, 3.52358e-02]],
+    },
+    "void": {
+        "sigt": [1.28407e-02, 1.20676e-02],
+        "sigs": [[1.27700e-02, 2.40997e-05], [0.0, 1.07387e-02]],
+    },
+}
+
+
+def homogenize_pin(fuel, moderator, chi):
+    """Volume-weighted pin cell: cylinder of fuel (or guide tube) material in
+    a square of moderator."""
+    f = math.pi * C5G7_PIN_RADIUS ** 2 / C5G7_PITCH ** 2
+    n_group = len(moderator["sigt"])
+    mat = {
+        "sigt": [f * fuel["sigt"][g] + (1.0 - f) * moderator["sigt"][g]
+                 for g in range(n_group)],
+        "sigs": [[f * fuel["sigs"][gin][g] + (1.0 - f) * moderator["sigs"][gin][g]
+                  for g in range(n_group)] for gin in range(n_group)],
+    }
+    if "nusigf" in fuel:
+        mat["nusigf"] = [f * v for v in fuel["nusigf"]]
+        mat["chi"] = chi
+    return mat
+
+
+def fmt(values):
+    return ", ".join("%.6e" % v for v in values)
+
+
+def write_deck(case_dir, name, dim, materials, mid_rows, axis_max, ncells,
+               reflective, sn_order, refinements, comment):
+    """materials is an ordered list of dicts; material ids are 1-based in
+    mid.txt in the same order."""
+    os.makedirs(case_dir, exist_ok=True)
+    n_group = len(materials[0]["sigt"])
+    fissile = [i + 1 for i, m in enumerate(materials) if "nusigf" in m]
+    lines = []
+    for c in comment:
+        lines.append("# " + c)
+    lines += [
+        "set problem dimension                        = %d" % dim,
+        "set angular quadrature name                  = lsgc",
+        "set transport model                          = ep",
+        "set do print angular quadrature info         = false",
+        "set angular quadrature order                 = %d" % sn_order,
+        "set number of groups                         = %d" % n_group,
+        "set do eigenvalue calculations               = true",
+        "set do NDA                                   = false",
+        "set have reflective BC                       = true",
+        "set reflective boundary names                = %s" % ", ".join(reflective),
+        "",
+        "set uniform refinements                      = %d" % refinements,
+        "",
+        "set HO linear solver name                    = bicgstab",
+        "set HO preconditioner name                   = amg",
+        "",
+        "set x, y, z max values of boundary locations = %s" % ", ".join("%g" % v for v in axis_max),
+        "set number of cells for x, y, z directions   = %s" % ", ".join(str(n) for n in ncells),
+        "set number of materials                      = %d" % len(materials),
+        "",
+        "set spatial discretization                   = cfem",
+        "",
+        "set finite element polynomial degree         = 1",
+        "",
+        "set output file name base                    = %s" % name,
+        "",
+        "subsection material ID map",
+        "set material id file name                    = mid.txt",
+        "end",
+        "",
+        "subsection sigma_t, group=1 to G",
+    ]
+    for i, m in enumerate(materials):
+        lines.append("set material %-34d= %s" % (i + 1, fmt(m["sigt"])))
+    lines.append("end")
+    for i, m in enumerate(materials):
+        lines += ["", "subsection sigma_s, material %d" % (i + 1)]
+        for gin in range(n_group):
+            lines.append("set g_in %-36d= %s" % (gin + 1, fmt(m["sigs"][gin])))
+        lines.append("end")
+    lines += ["", "subsection fissile material IDs",
+              "set fissile material ids                     = %s" % ", ".join(str(i) for i in fissile),
+              "end", "", "subsection ksi, group=1 to G"]
+    for i in fissile:
+        lines.append("set material %-34d= %s" % (i, fmt(materials[i - 1]["chi"])))
+    lines += ["end", "", "subsection nu_sigf, group=1 to G"]
+    for i in fissile:
+        lines.append("set material %-34d= %s" % (i, fmt(materials[i - 1]["nusigf"])))
+    lines.append("end")
+
+    with open(os.path.join(case_dir, name), "w") as f:
+        f.write("\n".join(lines) + "\n")
+    # MeshGenerator reads one row of ncell_x ids per (y, z), y running fastest
+    with open(os.path.join(case_dir, "mid.txt"), "w") as f:
+        for row in mid_rows:
+            f.write(" ".join(str(v) for v in row) + "\n")
+
+
+def c5g7_pin_map():
+    """51x51 pin-cell map of the quarter core: UO2 at the reflective corner,
+    MOX next to it, UO2 diagonal, moderator reflector outside.  Returns ids
+    indexed [y][x] with 1=UO2 pin, 2=MOX pin, 3=guide tube pin,
+    4=moderator."""
+    assemblies = [["uo2", "mox", "mod"],
+                  ["mox", "uo2", "mod"],
+                  ["mod", "mod", "mod"]]
+    n = 3 * C5G7_NPIN
+    ids = [[4] * n for _ in range(n)]
+    for ay in range(3):
+        for ax in range(3):
+            kind = assemblies[ay][ax]
+            if kind == "mod":
+                continue
+            for py in range(C5G7_NPIN):
+                for px in range(C5G7_NPIN):
+                    if (py, px) in C5G7_GUIDE_TUBES:
+                        mid = 3
+                    else:
+                        mid = 1 if kind == "uo2" else 2
+                    ids[ay * C5G7_NPIN + py][ax * C5G7_NPIN + px] = mid
+    return ids
+
+
+def c5g7_materials():
+    mod = C5G7["moderator"]
+    return [homogenize_pin(C5G7["uo2"], mod, C5G7_CHI),
+            homogenize_pin(C5G7["mox43"], mod, C5G7_CHI),
+            homogenize_pin(C5G7["guide_tube"], mod, C5G7_CHI),
+            {"sigt": mod["sigt"], "sigs": mod["sigs"]}]
+
+
+def generate_c5g7_2d(out):
+    ids = c5g7_pin_map()
+    size = 3 * C5G7_NPIN * C5G7_PITCH
+    write_deck(os.path.join(out, "c5g7-2d"), "c5g7-2d", 2, c5g7_materials(),
+               ids, [size, size], [51, 51], ["xmin", "ymin"], 8, 0,
+               ["C5G7-style 2D quarter core, 7 groups, volume-homogenized pin cells.",
+                "MOX assemblies use the 4.3% MOX composition throughout and the",
+                "fission chamber is treated as a guide tube."])
+
+
+def generate_c5g7_3d(out):
+    ids = c5g7_pin_map()
+    size = 3 * C5G7_NPIN * C5G7_PITCH
+    # 64.26 cm axially in 12 layers: 8 fuel layers (42.84 cm) and 4 layers
+    # of top moderator reflector
+    nz, nz_fuel = 12, 8
+    rows = []
+    for z in range(nz):
+        for y in range(51):
+            rows.append(ids[y] if z < nz_fuel else [4] * 51)
+    write_deck(os.path.join(out, "c5g7-3d"), "c5g7-3d", 3, c5g7_materials(),
+               rows, [size, size, size], [51, 51, nz], ["xmin", "ymin", "zmin"],
+               4, 0,
+               ["C5G7-style 3D unrodded quarter core, 7 groups, volume-homogenized",
+                "pin cells, 42.84 cm of fuel under a 21.42 cm moderator reflector."])
+
+
+def generate_takeda(out, rodded):
+    # 25x25x25 cm quarter core in 5 cm cells: core in [0,15]^3, control rod
+    # channel at x in [15,20], y in [0,5] over the full height
+    materials = [TAKEDA["core"], TAKEDA["reflector"],
+                 TAKEDA["control_rod"] if rodded else TAKEDA["void"]]
+    rows = []
+    for z in range(5):
+        for y in range(5):
+            row = []
+            for x in range(5):
+                if x == 3 and y == 0:
+                    row.append(3)
+                elif x < 3 and y < 3 and z < 3:
+                    row.append(1)
+                else:
+                    row.append(2)
+            rows.append(row)
+    name = "takeda1-rod-in" if rodded else "takeda1-rod-out"
+    write_deck(os.path.join(out, name), name, 3, materials, rows,
+               [25.0, 25.0, 25.0], [5, 5, 5], ["xmin", "ymin", "zmin"], 8, 2,
+               ["Takeda model 1 (small LWR core), 2 groups, control rod %s." %
+                ("inserted" if rodded else "withdrawn")])
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    generate_c5g7_2d(out)
+    generate_c5g7_3d(out)
+    generate_takeda(out, False)
+    generate_takeda(out, True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Correctness and performance regression check for xtrans.
+
+Runs test-input/regression-suite.txt through xtrans-bench at fixed rank
+counts. Each run is checked in two ways:
+
+  correctness: keff and flux norms against the stored reference
+               test-input/regression/reference-np<N>.csv (relative
+               tolerance 1e-6 by default)
+  performance: phase timings and total linear/SI iterations against a
+               baseline from a known-good build on the same machine
+               (<work-dir>/baseline-np<N>.csv, 10% tolerance by default)
+
+References are the same on every machine and belong in the repository once
+a trusted build has produced them with --update; baselines stay on the
+machine. None are committed yet. Generate both, commit the references, then
+check a change with a plain run:
+
+  python3 regression.py --bench ./xtrans-bench --update
+  python3 regression.py --bench ./xtrans-bench
+
+A rank count without a reference is skipped for correctness; a missing
+baseline only skips the timing check. The build registers the plain run as
+the ctest test "regression" (ctest -L regression).
+
+The exit code is 0 if everything passed, 3 on wrong answers and 2 on slowdowns,
+matching xtrans-bench, and 77 if there was no reference to check against,
+which ctest reports as skipped.
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+
+# ctest SKIP_RETURN_CODE of the "regression" test
+SKIPPED = 77
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SUITE = os.path.join(HERE, "..", "test-input", "regression-suite.txt")
+REFERENCE_DIR = os.path.join(HERE, "..", "test-input", "regression")
+
+
+def run_suite(ranks, args):
+    output = os.path.join(args.work_dir, "results-np%d.csv" % ranks)
+    reference = os.path.join(REFERENCE_DIR, "reference-np%d.csv" % ranks)
+    baseline = os.path.join(args.work_dir, "baseline-np%d.csv" % ranks)
+    cmd = [args.mpirun, "-np", str(ranks)] + args.mpirun_args.split()
+    cmd += [os.path.abspath(args.bench), os.path.abspath(SUITE),
+            "--repeat", str(args.repeat), "--output", output]
+    has_reference = os.path.exists(reference)
+    if not args.update:
+        if has_reference:
+            cmd += ["--reference", reference,
+                    "--reference-tolerance", str(args.reference_tolerance)]
+        else:
+            print("no reference for %d ranks, run with --update on a "
+                  "trusted build and commit %s" % (ranks, reference))
+        if os.path.exists(baseline):
+            cmd += ["--baseline", baseline,
+                    "--tolerance", str(args.tolerance)]
+        else:
+            print("no timing baseline for %d ranks, run with --update" % ranks)
+    log_name = os.path.join(args.work_dir, "regression-np%d.log" % ranks)
+    with open(log_name, "w") as log:
+        status = subprocess.call(cmd, cwd=args.work_dir, stdout=log,
+                                 stderr=subprocess.STDOUT)
+    with open(log_name) as log:
+        for line in log:
+            if line.startswith("[") and not line.startswith("[ok]"):
+                sys.stdout.write("np%d %s" % (ranks, line))
+    if status == 1:
+        sys.exit("xtrans-bench failed on %d ranks, see %s" % (ranks, log_name))
+    if args.update:
+        os.makedirs(REFERENCE_DIR, exist_ok=True)
+        shutil.copyfile(output, reference)
+        shutil.copyfile(output, baseline)
+        print("np%d: wrote %s and %s" % (ranks, reference, baseline))
+    elif not has_reference and status == 0:
+        # nothing was checked for correctness
+        return SKIPPED
+    return status
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bench", default="./xtrans-bench")
+    parser.add_argument("--ranks", default="1,4",
+                        help="comma-separated rank counts, each with its "
+                        "own reference and baseline")
+    parser.add_argument("--repeat", type=int, default=3,
+                        help="repetitions per case, the fastest is kept")
+    parser.add_argument("--tolerance", type=float, default=0.1)
+    parser.add_argument("--reference-tolerance", type=float, default=1e-6)
+    parser.add_argument("--mpirun", default="mpirun")
+    parser.add_argument("--mpirun-args", default="--bind-to core")
+    parser.add_argument("--work-dir", default="regression-runs")
+    parser.add_argument("--update", action="store_true",
+                        help="store the results as new reference and baseline")
+    args = parser.parse_args()
+
+    os.makedirs(args.work_dir, exist_ok=True)
+    statuses = [run_suite(int(r), args) for r in args.ranks.split(",")]
+    worst = 0
+    for status in (3, 2, SKIPPED):
+        if status in statuses:
+            worst = status
+            break
+    print("regression check: %s" % {0: "passed", 2: "SLOWER than baseline",
+                                     3: "WRONG results",
+                                     SKIPPED: "SKIPPED, no reference"}[worst])
+    return worst
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Weak/strong scaling study for xtrans on a single machine.
+
+For every rank count in the list a deck plus mid.txt is generated, run through
+xtrans-bench with the local mpirun, and the per-phase timings are collected
+into a parallel-efficiency report.
+
+The problem is a 2-group core/reflector box built from the Takeda model 1
+materials: the core fills the lower-left corner of the domain and the
+boundaries through the origin are reflective.
+
+  strong scaling: the same deck for every rank count
+  weak scaling:   the coarse cell count grows with the rank count, the cell
+                  size stays fixed so the domain grows with it
+
+The coarse mesh has to be a whole number of cells per axis, so weak scaling
+cannot keep the cells per rank exactly constant. The report normalizes the
+weak efficiency by the actual cells per rank, and also lists time per HO
+linear iteration since larger domains need more source/power iterations.
+
+Usage:
+  python3 scaling_study.py --bench ./xtrans-bench --mode strong --ranks 1,2,4,8
+  python3 scaling_study.py --bench ./xtrans-bench --mode weak --ranks 1,2,4,8 \\
+      --dim 3 --cells-per-rank 64 --refinements 1 --sn-order 4
+"""
+
+import argparse
+import csv
+import os
+import subprocess
+import sys
+
+from generate_decks import TAKEDA, write_deck
+
+PHASES = ["make grid", "setup system", "assemble HO system",
+          "initialize HO preconditioners", "iterations", "output results",
+          "total"]
+
+
+def axis_cells(mode, dim, ranks, args):
+    if mode == "strong":
+        return args.cells
+    # round the per-axis count of cells_per_rank*ranks coarse cells
+    return max(1, int(round((args.cells_per_rank * ranks) ** (1.0 / dim))))
+
+
+def generate_case(work_dir, name, dim, n, args):
+    n_core = max(1, int(round(args.core_fraction * n)))
+    materials = [TAKEDA["core"], TAKEDA["reflector"]]
+    rows = []
+    for z in range(n if dim == 3 else 1):
+        for y in range(n):
+            rows.append([1 if (x < n_core and y < n_core and
+                               (dim == 2 or z < n_core)) else 2
+                         for x in range(n)])
+    size = n * args.cell_size
+    names = ["xmin", "ymin", "zmin"][:dim]
+    case_dir = os.path.join(work_dir, name)
+    write_deck(case_dir, name, dim, materials, rows, [size] * dim, [n] * dim,
+               names, args.sn_order, args.refinements,
+               ["Scaling study deck, %d^%d coarse cells, %d refinements." %
+                (n, dim, args.refinements)])
+    return os.path.join(name, name)
+
+
+def run_case(work_dir, name, deck, ranks, args):
+    suite = os.path.join(work_dir, name + ".suite")
+    overrides = "; ".join("%s=%s" % kv for kv in args.set)
+    with open(suite, "w") as f:
+        f.write("%s | %s | %s\n" % (name, deck, overrides))
+    output = os.path.join(work_dir, name + ".csv")
+    cmd = args.mpirun.split() + ["-np", str(ranks)] + args.mpirun_args.split()
+    cmd += [os.path.abspath(args.bench), os.path.abspath(suite),
+            "--repeat", str(args.repeat), "--output", os.path.abspath(output)]
+    print("running: " + " ".join(cmd), flush=True)
+    with open(os.path.join(work_dir, name + ".log"), "w") as log:
+        status = subprocess.call(cmd, cwd=work_dir, stdout=log,
+                                 stderr=subprocess.STDOUT)
+    if status != 0:
+        sys.exit("%s failed with status %d, see %s.log" % (name, status, name))
+    metrics = {}
+    with open(output) as f:
+        for row in csv.DictReader(f):
+            metrics[row["metric"]] = float(row["value"])
+    return metrics
+
+
+def report(mode, runs, out):
+    """runs is a list of (ranks, cells, metrics) ordered by rank count."""
+    base_ranks, base_cells, base = runs[0]
+
+    def efficiency(ranks, cells, t, t_base):
+        if t <= 0.0 or t_base <= 0.0:
+            return float("nan")
+        if mode == "strong":
+            return t_base * base_ranks / (t * ranks)
+        # work per rank relative to the base run
+        return t_base * (cells / ranks) / (t * base_cells / base_ranks)
+
+    lines = ["%s scaling, efficiency relative to %d rank(s)" % (mode, base_ranks),
+             ""]
+    header = "%-32s" % "phase" + "".join("%22s" % ("np=%d" % r) for r, _, _ in runs)
+    lines.append(header)
+    lines.append("%-32s" % "coarse cells per rank" +
+                 "".join("%22.1f" % (c / float(r)) for r, c, _ in runs))
+    rows = [("ranks", "phase", "wall_time", "efficiency")]
+    for phase in PHASES:
+        key = "time: " + phase
+        if key not in base:
+            continue
+        cells_text = []
+        for r, c, m in runs:
+            t = m.get(key, float("nan"))
+            e = efficiency(r, c, t, base[key])
+            cells_text.append("%22s" % ("%.3fs (%5.1f%%)" % (t, 100.0 * e)))
+            rows.append((r, phase, t, e))
+        lines.append("%-32s" % phase + "".join(cells_text))
+    for metric in ["SI iterations", "HO linear iterations"]:
+        lines.append("%-32s" % metric +
+                     "".join("%22d" % m.get(metric, 0) for _, _, m in runs))
+    per_iter = []
+    for r, c, m in runs:
+        iters = m.get("HO linear iterations", 0.0)
+        t = m.get("time: iterations", float("nan"))
+        per_iter.append("%22s" % ("%.3es" % (t / iters) if iters > 0 else "n/a"))
+    lines.append("%-32s" % "time per HO linear iteration" + "".join(per_iter))
+
+    text = "\n".join(lines) + "\n"
+    print("\n" + text)
+    with open(out + ".txt", "w") as f:
+        f.write(text)
+    with open(out + ".csv", "w") as f:
+        csv.writer(f).writerows(rows)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--bench", required=True, help="path to xtrans-bench")
+    parser.add_argument("--mode", choices=["weak", "strong"], default="strong")
+    parser.add_argument("--ranks", default="1,2,4",
+                        help="comma separated rank counts")
+    parser.add_argument("--dim", type=int, choices=[2, 3], default=2)
+    parser.add_argument("--cells", type=int, default=16,
+                        help="coarse cells per axis for strong scaling")
+    parser.add_argument("--cells-per-rank", type=int, default=64,
+                        help="coarse cells per rank for weak scaling")
+    parser.add_argument("--cell-size", type=float, default=5.0,
+                        help="coarse cell size in cm")
+    parser.add_argument("--core-fraction", type=float, default=0.6,
+                        help="fraction of each axis covered by the core")
+    parser.add_argument("--refinements", type=int, default=2)
+    parser.add_argument("--sn-order", type=int, default=4)
+    parser.add_argument("--set", action="append", default=[], type=lambda s: tuple(s.split("=", 1)),
+                        metavar="ENTRY=VALUE",
+                        help="extra deck override, e.g. 'HO linear solver name=gmres'")
+    parser.add_argument("--repeat", type=int, default=1)
+    parser.add_argument("--mpirun", default="mpirun")
+    parser.add_argument("--mpirun-args", default="--bind-to core",
+                        help="extra mpirun arguments placed after -np")
+    parser.add_argument("--work-dir", default="scaling-study")
+    parser.add_argument("--report", default=None,
+                        help="report base name, default <work-dir>/<mode>-report")
+    args = parser.parse_args()
+
+    ranks = sorted(int(r) for r in args.ranks.split(","))
+    n_cores = os.cpu_count() or 1
+    if ranks[-1] > n_cores:
+        print("warning: %d ranks on %d cores, timings will be oversubscribed" %
+              (ranks[-1], n_cores))
+    os.makedirs(args.work_dir, exist_ok=True)
+
+    runs = []
+    for r in ranks:
+        n = axis_cells(args.mode, args.dim, r, args)
+        name = "%s-np%d" % (args.mode, r)
+        deck = generate_case(args.work_dir, name, args.dim, n, args)
+        metrics = run_case(args.work_dir, name, deck, r, args)
+        runs.append((r, n ** args.dim, metrics))
+
+    report(args.mode, runs,
+           args.report or os.path.join(args.work_dir, args.mode + "-report"))
+
+
+if __name__ == "__main__":
+    main()
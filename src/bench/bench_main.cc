@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------
+ *
+ * Benchmark driver running a suite of input decks through the library,
+ * checking keff and flux norms against a reference and comparing phase
+ * timings and iteration counts against a baseline.
+ *
+ * ----------------------------------------------------------------------
+ */
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/utilities.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "benchmark_suite.h"
+
+using namespace dealii;
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    using namespace dealii;
+    
+    if (argc<2)
+    {
+      std::cerr << "Call the program as mpirun -np num_proc xtrans-bench suite_file"
+      << " [--repeat n] [--output results.csv] [--baseline baseline.csv]"
+      << " [--tolerance 0.1] [--reference reference.csv]"
+      << " [--reference-tolerance 1e-6]" << std::endl;
+      return 1;
+    }
+    Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+    
+    std::string suite_filename = argv[1];
+    std::string output_filename = "bench_results.csv";
+    std::string baseline_filename = "";
+    std::string reference_filename = "";
+    unsigned int n_repeats = 1;
+    double tolerance = 0.1;
+    double reference_tolerance = 1.0e-6;
+    for (int i=2; i+1<argc; i+=2)
+    {
+      std::string option = argv[i];
+      if (option=="--repeat")
+        n_repeats = std::atoi (argv[i+1]);
+      else if (option=="--output")
+        output_filename = argv[i+1];
+      else if (option=="--baseline")
+        baseline_filename = argv[i+1];
+      else if (option=="--tolerance")
+        tolerance = std::atof (argv[i+1]);
+      else if (option=="--reference")
+        reference_filename = argv[i+1];
+      else if (option=="--reference-tolerance")
+        reference_tolerance = std::atof (argv[i+1]);
+      else
+        AssertThrow (false, ExcMessage ("unknown option " + option));
+    }
+    
+    BenchmarkSuite suite (suite_filename);
+    suite.run (n_repeats);
+    suite.write_results (output_filename);
+    // wrong answers take precedence over slow ones
+    if (reference_filename!="" &&
+        !suite.compare_with_reference (reference_filename, reference_tolerance))
+      return 3;
+    if (baseline_filename!="" &&
+        !suite.compare_with_baseline (baseline_filename, tolerance))
+      return 2;
+  }
+  catch (std::exception &exc)
+  {
+    std::cerr << std::endl << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    std::cerr << "Exception on processing: " << std::endl
+    << exc.what() << std::endl
+    << "Aborting!" << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    return 1;
+  }
+  catch (...)
+  {
+    std::cerr << std::endl << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    std::cerr << "Unknown exception!" << std::endl
+    << "Aborting!" << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,254 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/conditional_ostream.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+
+#include "benchmark_suite.h"
+#include "../common/problem_definition.h"
+#include "../common/model_manager.h"
+
+BenchmarkSuite::BenchmarkSuite (std::string suite_filename)
+:
+mpi_communicator(MPI_COMM_WORLD)
+{
+  read_suite (suite_filename);
+}
+
+BenchmarkSuite::~BenchmarkSuite ()
+{
+}
+
+void BenchmarkSuite::read_suite (std::string suite_filename)
+{
+  std::size_t pos = suite_filename.find_last_of ('/');
+  suite_dir = (pos==std::string::npos ? "" : suite_filename.substr (0, pos + 1));
+
+  std::ifstream in (suite_filename.c_str ());
+  AssertThrow (in.is_open (),
+               ExcMessage ("cannot open benchmark suite file " + suite_filename));
+  std::string line;
+  while (std::getline (in, line))
+  {
+    boost::algorithm::trim (line);
+    if (line.size()==0 || line[0]=='#')
+      continue;
+    std::vector<std::string> strings = Utilities::split_string_list (line, '|');
+    AssertThrow (strings.size()>=2,
+                 ExcMessage ("benchmark case needs at least a name and a deck: " + line));
+    BenchmarkCase bench_case;
+    bench_case.name = strings[0];
+    bench_case.deck = suite_dir + strings[1];
+    if (strings.size()>2)
+    {
+      std::vector<std::string> entries = Utilities::split_string_list (strings[2], ';');
+      for (unsigned int i=0; i<entries.size(); ++i)
+      {
+        std::size_t eq = entries[i].find ('=');
+        AssertThrow (eq!=std::string::npos,
+                     ExcMessage ("parameter overrides must be entry=value: " + entries[i]));
+        std::string key = entries[i].substr (0, eq);
+        std::string value = entries[i].substr (eq + 1);
+        boost::algorithm::trim (key);
+        boost::algorithm::trim (value);
+        bench_case.overrides.push_back (std::make_pair (key, value));
+      }
+    }
+    cases.push_back (bench_case);
+  }
+  in.close ();
+}
+
+std::string BenchmarkSuite::resolve_path (std::string deck,
+                                          std::string filename)
+{
+  // decks refer to mid.txt etc. relative to where they live
+  if (filename.size()==0 || filename[0]=='/')
+    return filename;
+  std::size_t pos = deck.find_last_of ('/');
+  return (pos==std::string::npos ? "" : deck.substr (0, pos + 1)) + filename;
+}
+
+void BenchmarkSuite::prepare_parameters (BenchmarkCase &bench_case,
+                                         ParameterHandler &prm)
+{
+  ProblemDefinition::declare_parameters (prm);
+  prm.read_input (bench_case.deck);
+  for (unsigned int i=0; i<bench_case.overrides.size(); ++i)
+    prm.set (bench_case.overrides[i].first, bench_case.overrides[i].second);
+
+  prm.set ("mesh file name", resolve_path (bench_case.deck,
+                                             prm.get ("mesh file name")));
+  prm.set ("output file name base", "bench-" + bench_case.name);
+  prm.enter_subsection ("material ID map");
+  {
+    prm.set ("material id file name",
+             resolve_path (bench_case.deck,
+                           prm.get ("material id file name")));
+  }
+  prm.leave_subsection ();
+}
+
+std::map<std::string, double> BenchmarkSuite::run_case (BenchmarkCase &bench_case)
+{
+  ParameterHandler prm;
+  prepare_parameters (bench_case, prm);
+
+  Timer timer (mpi_communicator, true);
+  timer.start ();
+  ModelManager modeler (prm);
+  modeler.build_and_run_model (prm);
+  timer.stop ();
+
+  std::map<std::string, double> summary = modeler.get_run_summary ();
+  summary["time: total"] = timer.wall_time ();
+  // timings are only comparable at the same process count
+  summary["processes"] = Utilities::MPI::n_mpi_processes (mpi_communicator);
+  // phases are timed per process; the slowest process is what matters
+  for (std::map<std::string, double>::iterator it=summary.begin ();
+       it!=summary.end (); ++it)
+    if (it->first.find ("time: ")==0)
+      it->second = Utilities::MPI::max (it->second, mpi_communicator);
+  return summary;
+}
+
+void BenchmarkSuite::run (unsigned int n_repeats)
+{
+  AssertThrow (n_repeats>0,
+               ExcMessage ("at least one repetition is needed per case"));
+  results.clear ();
+  for (unsigned int i=0; i<cases.size(); ++i)
+  {
+    std::map<std::string, double> best;
+    for (unsigned int r=0; r<n_repeats; ++r)
+    {
+      std::map<std::string, double> summary = run_case (cases[i]);
+      // keep the fastest repetition for timings
+      for (std::map<std::string, double>::iterator it=summary.begin ();
+           it!=summary.end (); ++it)
+        if (r==0 || (it->first.find ("time: ")==0 && it->second<best[it->first]))
+          best[it->first] = it->second;
+    }
+    results.push_back (best);
+  }
+}
+
+void BenchmarkSuite::write_results (std::string filename)
+{
+  if (Utilities::MPI::this_mpi_process (mpi_communicator)!=0)
+    return;
+  std::ofstream out (filename.c_str ());
+  out << "case,metric,value" << std::endl;
+  out << std::setprecision (12);
+  for (unsigned int i=0; i<cases.size(); ++i)
+    for (std::map<std::string, double>::iterator it=results[i].begin ();
+         it!=results[i].end (); ++it)
+      out << cases[i].name << "," << it->first << "," << it->second << std::endl;
+  out.close ();
+}
+
+std::map<std::pair<std::string, std::string>, double>
+BenchmarkSuite::read_results (std::string filename)
+{
+  std::map<std::pair<std::string, std::string>, double> values;
+  std::ifstream in (filename.c_str ());
+  AssertThrow (in.is_open (),
+               ExcMessage ("cannot open results file " + filename));
+  std::string line;
+  std::getline (in, line);
+  while (std::getline (in, line))
+  {
+    std::vector<std::string> strings = Utilities::split_string_list (line, ',');
+    if (strings.size()!=3)
+      continue;
+    values[std::make_pair (strings[0], strings[1])] = std::atof (strings[2].c_str ());
+  }
+  in.close ();
+  return values;
+}
+
+bool BenchmarkSuite::compare_with_reference (std::string reference_filename,
+                                             double tolerance)
+{
+  std::map<std::pair<std::string, std::string>, double> reference =
+  read_results (reference_filename);
+
+  // keff and flux norms have to agree with the reference to a relative
+  // tolerance; a missing reference value is a failure as well, so that a
+  // case cannot silently drop out of the check
+  bool pass = true;
+  ConditionalOStream pcout (std::cout,
+                            Utilities::MPI::this_mpi_process (mpi_communicator)==0);
+  for (unsigned int i=0; i<cases.size(); ++i)
+    for (std::map<std::string, double>::iterator it=results[i].begin ();
+         it!=results[i].end (); ++it)
+    {
+      if (it->first!="keff" && it->first.find ("phi l1 norm")!=0)
+        continue;
+      std::pair<std::string, std::string> key (cases[i].name, it->first);
+      if (reference.find (key)==reference.end ())
+      {
+        pass = false;
+        pcout << "[MISSING] " << cases[i].name << ", " << it->first << std::endl;
+        continue;
+      }
+      double ref = reference[key];
+      bool is_wrong = std::fabs (it->second - ref) > tolerance * std::fabs (ref);
+      pass = pass && !is_wrong;
+      pcout << (is_wrong ? "[WRONG] " : "[ok] ")
+      << std::setprecision (10) << cases[i].name << ", " << it->first << ": "
+      << it->second << " (reference " << ref << ")" << std::endl;
+    }
+  return pass;
+}
+
+bool BenchmarkSuite::compare_with_baseline (std::string baseline_filename,
+                                            double tolerance)
+{
+  std::map<std::pair<std::string, std::string>, double> baseline =
+  read_results (baseline_filename);
+
+  // only timings and iteration counts are performance metrics; slower or
+  // more iterations than baseline*(1+tolerance) is a regression
+  bool pass = true;
+  ConditionalOStream pcout (std::cout,
+                            Utilities::MPI::this_mpi_process (mpi_communicator)==0);
+  for (unsigned int i=0; i<cases.size(); ++i)
+  {
+    std::pair<std::string, std::string> processes (cases[i].name, "processes");
+    if (baseline.find (processes)!=baseline.end () &&
+        baseline[processes]!=results[i]["processes"])
+    {
+      pass = false;
+      pcout << "[MISMATCH] " << cases[i].name << ": baseline was run on "
+      << baseline[processes] << " processes" << std::endl;
+      continue;
+    }
+    for (std::map<std::string, double>::iterator it=results[i].begin ();
+         it!=results[i].end (); ++it)
+    {
+      if (it->first.find ("time: ")!=0 &&
+          it->first.find ("iterations")==std::string::npos)
+        continue;
+      std::pair<std::string, std::string> key (cases[i].name, it->first);
+      if (baseline.find (key)==baseline.end ())
+      {
+        pcout << "[no baseline] " << cases[i].name << ", " << it->first << std::endl;
+        continue;
+      }
+      double ref = baseline[key];
+      bool is_regression = it->second > ref * (1.0 + tolerance);
+      pass = pass && !is_regression;
+      pcout << (is_regression ? "[REGRESSION] " : "[ok] ")
+      << cases[i].name << ", " << it->first << ": " << it->second
+      << " (baseline " << ref << ")" << std::endl;
+    }
+  }
+  return pass;
+}
@@ -0,0 +1,60 @@
+#ifndef __benchmark_suite_h__
+#define __benchmark_suite_h__
+
+#include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/mpi.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dealii;
+
+// A benchmark suite is a text file with one case per line:
+//   case name | input deck | entry=value; entry=value; ...
+// Decks are relative to the suite file, files named in a deck are relative to
+// the deck, and the entries override top-level parameters of the deck, e.g.
+// "uniform refinements=4".
+class BenchmarkSuite
+{
+public:
+  BenchmarkSuite (std::string suite_filename);
+  ~BenchmarkSuite ();
+
+  void run (unsigned int n_repeats);
+  void write_results (std::string filename);
+  // performance: timings and iteration counts may not exceed the baseline
+  // by more than the relative tolerance
+  bool compare_with_baseline (std::string baseline_filename,
+                              double tolerance);
+  // correctness: keff and flux norms have to match the reference to within
+  // the relative tolerance
+  bool compare_with_reference (std::string reference_filename,
+                               double tolerance);
+
+private:
+  struct BenchmarkCase
+  {
+    std::string name;
+    std::string deck;
+    std::vector<std::pair<std::string, std::string> > overrides;
+  };
+
+  void read_suite (std::string suite_filename);
+  void prepare_parameters (BenchmarkCase &bench_case,
+                           ParameterHandler &prm);
+  std::map<std::pair<std::string, std::string>, double>
+  read_results (std::string filename);
+  std::string resolve_path (std::string deck, std::string filename);
+  std::map<std::string, double> run_case (BenchmarkCase &bench_case);
+
+  std::string suite_dir;
+  std::vector<BenchmarkCase> cases;
+  // metric name to value per case
+  std::vector<std::map<std::string, double> > results;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__benchmark_suite_h__
@@ -0,0 +1,248 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/fe/fe_values.h>
+
+#include <algorithm>
+
+#include "kernel_benchmark.h"
+#include "../aqdata/aq_lsgc.h"
+
+template <int dim>
+KernelBenchmark<dim>::KernelBenchmark (ParameterHandler &prm)
+:
+prm(prm),
+n_interior_faces(0),
+mpi_communicator(MPI_COMM_WORLD)
+{
+  tb_ptr = std_cxx11::shared_ptr<TransportBase<dim> >
+  (new EvenParity<dim> (prm));
+  setup ();
+}
+
+template <int dim>
+KernelBenchmark<dim>::~KernelBenchmark ()
+{
+}
+
+template <int dim>
+unsigned int KernelBenchmark<dim>::get_n_dir ()
+{
+  return tb_ptr->n_dir;
+}
+
+template <int dim>
+unsigned int KernelBenchmark<dim>::get_dofs_per_cell ()
+{
+  return tb_ptr->dofs_per_cell;
+}
+
+template <int dim>
+void KernelBenchmark<dim>::setup ()
+{
+  TransportBase<dim> &tb = *tb_ptr;
+  tb.msh_ptr->make_grid (tb.triangulation);
+  tb.msh_ptr->get_relevant_cell_iterators (tb.dof_handler,
+                                           tb.local_cells,
+                                           tb.ref_bd_cells,
+                                           tb.is_cell_at_bd,
+                                           tb.is_cell_at_ref_bd);
+  tb.setup_system ();
+
+  // same pre-assembly as TransportBase::assemble_ho_volume_boundary
+  streaming_at_qp.resize (tb.n_q, std::vector<FullMatrix<double> >
+                          (tb.n_dir, FullMatrix<double> (tb.dofs_per_cell,
+                                                         tb.dofs_per_cell)));
+  collision_at_qp.resize (tb.n_q, FullMatrix<double> (tb.dofs_per_cell,
+                                                      tb.dofs_per_cell));
+  typename DoFHandler<dim>::active_cell_iterator cell = tb.local_cells[0];
+  tb.fv->reinit (cell);
+  tb.pre_assemble_cell_matrices (tb.fv, cell, streaming_at_qp, collision_at_qp);
+
+  for (unsigned int ic=0; ic<tb.local_cells.size(); ++ic)
+  {
+    tb.vec_test_at_qp.push_back (FullMatrix<double> (tb.n_q, tb.dofs_per_cell));
+    tb.fv->reinit (tb.local_cells[ic]);
+    for (unsigned int qi=0; qi<tb.n_q; ++qi)
+      for (unsigned int i=0; i<tb.dofs_per_cell; ++i)
+        tb.vec_test_at_qp[ic](qi, i) = tb.fv->shape_value (i,qi) * tb.fv->JxW (qi);
+  }
+
+  // a flat angular flux gives a nonzero scalar flux for the RHS kernel
+  for (unsigned int k=0; k<tb.n_total_ho_vars; ++k)
+    *(tb.vec_aflx[k]) = 1.0;
+  tb.generate_moments ();
+}
+
+template <int dim>
+double KernelBenchmark<dim>::time_cell_loop (bool do_integrate)
+{
+  TransportBase<dim> &tb = *tb_ptr;
+  FullMatrix<double> local_mat (tb.dofs_per_cell, tb.dofs_per_cell);
+  unsigned int g = 0;
+  Timer timer;
+  timer.start ();
+  for (unsigned int ic=0; ic<tb.local_cells.size(); ++ic)
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = tb.local_cells[ic];
+    tb.fv->reinit (cell);
+    if (do_integrate)
+      for (unsigned int i_dir=0; i_dir<tb.n_dir; ++i_dir)
+      {
+        local_mat = 0;
+        tb.integrate_cell_bilinear_form (tb.fv, cell, local_mat, i_dir, g,
+                                         streaming_at_qp, collision_at_qp);
+      }
+  }
+  timer.stop ();
+  return timer.wall_time ();
+}
+
+template <int dim>
+double KernelBenchmark<dim>::time_interface_loop (bool do_integrate)
+{
+  TransportBase<dim> &tb = *tb_ptr;
+  FullMatrix<double> vp_up (tb.dofs_per_cell, tb.dofs_per_cell);
+  FullMatrix<double> vp_un (tb.dofs_per_cell, tb.dofs_per_cell);
+  FullMatrix<double> vn_up (tb.dofs_per_cell, tb.dofs_per_cell);
+  FullMatrix<double> vn_un (tb.dofs_per_cell, tb.dofs_per_cell);
+  unsigned int g = 0;
+  n_interior_faces = 0;
+  Timer timer;
+  timer.start ();
+  for (unsigned int ic=0; ic<tb.local_cells.size(); ++ic)
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = tb.local_cells[ic];
+    for (unsigned int fn=0; fn<GeometryInfo<dim>::faces_per_cell; ++fn)
+      if (!cell->at_boundary(fn) &&
+          cell->neighbor(fn)->id()<cell->id())
+      {
+        ++n_interior_faces;
+        tb.fvf->reinit (cell, fn);
+        typename DoFHandler<dim>::cell_iterator neigh = cell->neighbor(fn);
+        tb.fvf_nei->reinit (neigh, cell->neighbor_face_no(fn));
+        if (do_integrate)
+          for (unsigned int i_dir=0; i_dir<tb.n_dir; ++i_dir)
+          {
+            vp_up = 0;
+            vp_un = 0;
+            vn_up = 0;
+            vn_un = 0;
+            tb.integrate_interface_bilinear_form (tb.fvf, tb.fvf_nei,
+                                                  cell, neigh,
+                                                  fn,
+                                                  i_dir, g,
+                                                  vp_up, vp_un, vn_up, vn_un);
+          }
+      }
+  }
+  timer.stop ();
+  return timer.wall_time ();
+}
+
+template <int dim>
+double KernelBenchmark<dim>::time_ho_rhs ()
+{
+  Timer timer;
+  timer.start ();
+  tb_ptr->generate_ho_rhs ();
+  timer.stop ();
+  return timer.wall_time ();
+}
+
+template <int dim>
+double KernelBenchmark<dim>::time_moments ()
+{
+  Timer timer;
+  timer.start ();
+  tb_ptr->generate_moments ();
+  timer.stop ();
+  return timer.wall_time ();
+}
+
+template <int dim>
+double KernelBenchmark<dim>::time_angular_quad ()
+{
+  // produce_angular_quad appends to the direction lists, so every call
+  // needs a fresh object
+  AQLSGC<dim> aq (prm);
+  Timer timer;
+  timer.start ();
+  aq.produce_angular_quad ();
+  timer.stop ();
+  return timer.wall_time ();
+}
+
+template <int dim>
+typename KernelBenchmark<dim>::KernelResult
+KernelBenchmark<dim>::make_result (std::string kernel, unsigned int n_items,
+                                   double seconds, double flops)
+{
+  KernelResult result;
+  result.kernel = kernel;
+  result.n_items = Utilities::MPI::sum (n_items, mpi_communicator);
+  result.seconds = Utilities::MPI::max (seconds, mpi_communicator);
+  result.flops = Utilities::MPI::sum (flops, mpi_communicator);
+  return result;
+}
+
+template <int dim>
+std::vector<typename KernelBenchmark<dim>::KernelResult>
+KernelBenchmark<dim>::run (unsigned int n_repeats)
+{
+  TransportBase<dim> &tb = *tb_ptr;
+  const double n_cells = tb.local_cells.size ();
+  const double n_dir = tb.n_dir;
+  const double n_group = tb.n_group;
+  const double n_q = tb.n_q;
+  const double n_qf = tb.n_qf;
+  const double dpc = tb.dofs_per_cell;
+  const double n_local_dofs = tb.local_dofs.n_elements ();
+  const bool is_dfem = tb.discretization=="dfem";
+
+  // fastest repetition per kernel; cell and face loops are timed with and
+  // without the kernel call s.t. FEValues::reinit is not charged to it
+  std::vector<double> best (5, 1.0e300);
+  for (unsigned int r=0; r<n_repeats; ++r)
+  {
+    best[0] = std::min (best[0],
+                        std::max (0.0, time_cell_loop (true) - time_cell_loop (false)));
+    if (is_dfem)
+      best[1] = std::min (best[1],
+                          std::max (0.0, (time_interface_loop (true) -
+                                          time_interface_loop (false))));
+    best[2] = std::min (best[2], time_ho_rhs ());
+    best[3] = std::min (best[3], time_moments ());
+    best[4] = std::min (best[4], time_angular_quad ());
+  }
+
+  std::vector<KernelResult> results;
+  // streaming and collision terms, sum and JxW scaling per (qi,i,j)
+  results.push_back (make_result ("integrate_cell_bilinear_form",
+                                  tb.local_cells.size (), best[0],
+                                  5.0 * n_q * dpc * dpc * n_dir * n_cells));
+  if (is_dfem)
+    // penalty term and two consistency terms for each of the four blocks
+    results.push_back (make_result ("integrate_interface_bilinear_form",
+                                    n_interior_faces, best[1],
+                                    4.0 * (4.0 * dim + 10.0) * n_qf * dpc * dpc *
+                                    n_dir * n_interior_faces));
+  // get_function_values, scattering sum and test function product; the
+  // remaining directions of each group copy the first one
+  results.push_back (make_result ("generate_ho_rhs",
+                                  tb.local_cells.size () * tb.n_group, best[2],
+                                  n_group * (n_cells * (2.0 * n_group * n_q * dpc +
+                                                        n_q * (2.0 * n_group + 2.0 * dpc)) +
+                                             n_local_dofs)));
+  results.push_back (make_result ("generate_moments",
+                                  tb.local_cells.size () * tb.n_group, best[3],
+                                  2.0 * n_group * n_dir * n_local_dofs));
+  // the quadrature is set up on every process; report it once
+  results.push_back (make_result ("AQLSGC::produce_angular_quad",
+                                  (Utilities::MPI::this_mpi_process (mpi_communicator)==0 ?
+                                   tb.n_dir : 0),
+                                  best[4], 0.0));
+  return results;
+}
+
+template class KernelBenchmark<2>;
+template class KernelBenchmark<3>;
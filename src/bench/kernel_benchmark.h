@@ -0,0 +1,62 @@
+#ifndef __kernel_benchmark_h__
+#define __kernel_benchmark_h__
+
+#include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/mpi.h>
+
+#include <string>
+#include <vector>
+
+#include "../transport/even_parity.h"
+
+using namespace dealii;
+
+// Times the hot kernels of the even parity solver in isolation on the mesh
+// of an input deck. Every measurement is repeated and the fastest repetition
+// is kept; times are the max over processes, cell counts the sum.
+//
+// FLOP counts are nominal: they follow the arithmetic as written in the
+// kernels and do not account for what the compiler folds away.
+template <int dim>
+class KernelBenchmark
+{
+public:
+  struct KernelResult
+  {
+    std::string kernel;
+    unsigned int n_items;
+    double seconds;
+    double flops;
+  };
+
+  KernelBenchmark (ParameterHandler &prm);
+  ~KernelBenchmark ();
+
+  std::vector<KernelResult> run (unsigned int n_repeats);
+
+  unsigned int get_n_dir ();
+  unsigned int get_dofs_per_cell ();
+
+private:
+  void setup ();
+  double time_cell_loop (bool do_integrate);
+  double time_interface_loop (bool do_integrate);
+  double time_ho_rhs ();
+  double time_moments ();
+  double time_angular_quad ();
+  KernelResult make_result (std::string kernel, unsigned int n_items,
+                            double seconds, double flops);
+
+  ParameterHandler &prm;
+  // the kernels are called through the base class as in the assembly loops
+  std_cxx11::shared_ptr<TransportBase<dim> > tb_ptr;
+
+  std::vector<std::vector<FullMatrix<double> > > streaming_at_qp;
+  std::vector<FullMatrix<double> > collision_at_qp;
+
+  unsigned int n_interior_faces;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__kernel_benchmark_h__
@@ -0,0 +1,179 @@
+/* ---------------------------------------------------------------------
+ *
+ * Microbenchmark driver timing the assembly, RHS, moment and angular
+ * quadrature kernels on the mesh of an input deck for a range of
+ * finite element and SN orders.
+ *
+ * ----------------------------------------------------------------------
+ */
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/conditional_ostream.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "kernel_benchmark.h"
+#include "../common/problem_definition.h"
+
+using namespace dealii;
+
+// files named in the deck are relative to the deck
+std::string resolve_path (std::string deck, std::string filename)
+{
+  if (filename.size()==0 || filename[0]=='/')
+    return filename;
+  std::size_t pos = deck.find_last_of ('/');
+  return (pos==std::string::npos ? "" : deck.substr (0, pos + 1)) + filename;
+}
+
+template <int dim>
+void run_kernels (ParameterHandler &prm,
+                  unsigned int p_order,
+                  unsigned int sn_order,
+                  unsigned int n_repeats,
+                  ConditionalOStream &pcout,
+                  std::ofstream &out)
+{
+  KernelBenchmark<dim> bench (prm);
+  std::vector<typename KernelBenchmark<dim>::KernelResult> results =
+  bench.run (n_repeats);
+  for (unsigned int i=0; i<results.size(); ++i)
+  {
+    double rate = results[i].seconds>0.0 ? results[i].n_items / results[i].seconds : 0.0;
+    double gflops = results[i].seconds>0.0 ? results[i].flops / results[i].seconds * 1.0e-9 : 0.0;
+    pcout << std::setw(34) << std::left << results[i].kernel
+    << std::setw(4) << std::right << p_order
+    << std::setw(5) << sn_order
+    << std::setw(7) << bench.get_n_dir ()
+    << std::setw(6) << bench.get_dofs_per_cell ()
+    << std::setw(11) << results[i].n_items
+    << std::setw(13) << std::scientific << std::setprecision(3) << results[i].seconds
+    << std::setw(13) << rate
+    << std::setw(10) << std::fixed << std::setprecision(3) << gflops << std::endl;
+    if (out.is_open ())
+      out << results[i].kernel << "," << p_order << "," << sn_order << ","
+      << bench.get_n_dir () << "," << bench.get_dofs_per_cell () << ","
+      << results[i].n_items << "," << results[i].seconds << ","
+      << rate << "," << gflops << std::endl;
+  }
+  pcout.get_stream().unsetf (std::ios_base::floatfield);
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    using namespace dealii;
+
+    if (argc<2)
+    {
+      std::cerr << "Call the program as mpirun -np num_proc xtrans-kernels input_file_name"
+      << " [--p-orders 1,2,3] [--sn-orders 4,8,16] [--discretization dfem]"
+      << " [--repeat n] [--output kernels.csv]" << std::endl;
+      return 1;
+    }
+    Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+
+    std::string deck = argv[1];
+    std::string p_orders = "1,2,3";
+    std::string sn_orders = "4,8,16";
+    std::string discretization = "dfem";
+    std::string output_filename = "";
+    unsigned int n_repeats = 3;
+    for (int i=2; i+1<argc; i+=2)
+    {
+      std::string option = argv[i];
+      if (option=="--p-orders")
+        p_orders = argv[i+1];
+      else if (option=="--sn-orders")
+        sn_orders = argv[i+1];
+      else if (option=="--discretization")
+        discretization = argv[i+1];
+      else if (option=="--repeat")
+        n_repeats = std::atoi (argv[i+1]);
+      else if (option=="--output")
+        output_filename = argv[i+1];
+      else
+        AssertThrow (false, ExcMessage ("unknown option " + option));
+    }
+    AssertThrow (n_repeats>0,
+                 ExcMessage ("at least one repetition is needed per kernel"));
+
+    bool is_root = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD)==0;
+    ConditionalOStream pcout (std::cout, is_root);
+    std::ofstream out;
+    if (output_filename!="" && is_root)
+    {
+      out.open (output_filename.c_str ());
+      out << "kernel,p_order,sn_order,n_dir,dofs_per_cell,items,seconds,"
+      << "items_per_second,gflops" << std::endl;
+    }
+    pcout << "items are cells, interior faces for the interface form, cell-groups"
+    << " for RHS and moments and directions for the angular quadrature" << std::endl;
+    pcout << std::setw(34) << std::left << "kernel"
+    << std::setw(4) << std::right << "p"
+    << std::setw(5) << "SN"
+    << std::setw(7) << "n_dir"
+    << std::setw(6) << "dofs"
+    << std::setw(11) << "items"
+    << std::setw(13) << "time (s)"
+    << std::setw(13) << "items/s"
+    << std::setw(10) << "GFLOP/s" << std::endl;
+
+    std::vector<int> p_list = Utilities::string_to_int
+    (Utilities::split_string_list (p_orders));
+    std::vector<int> sn_list = Utilities::string_to_int
+    (Utilities::split_string_list (sn_orders));
+    for (unsigned int ip=0; ip<p_list.size(); ++ip)
+      for (unsigned int isn=0; isn<sn_list.size(); ++isn)
+      {
+        ParameterHandler prm;
+        ProblemDefinition::declare_parameters (prm);
+        prm.read_input (deck);
+        prm.set ("finite element polynomial degree", Utilities::int_to_string (p_list[ip]));
+        prm.set ("angular quadrature order", Utilities::int_to_string (sn_list[isn]));
+        prm.set ("spatial discretization", discretization);
+        prm.set ("do print angular quadrature info", "false");
+        prm.set ("mesh file name", resolve_path (deck, prm.get ("mesh file name")));
+        prm.enter_subsection ("material ID map");
+        {
+          prm.set ("material id file name",
+                   resolve_path (deck, prm.get ("material id file name")));
+        }
+        prm.leave_subsection ();
+
+        if (prm.get_integer ("problem dimension")==2)
+          run_kernels<2> (prm, p_list[ip], sn_list[isn], n_repeats, pcout, out);
+        else
+          run_kernels<3> (prm, p_list[ip], sn_list[isn], n_repeats, pcout, out);
+      }
+  }
+  catch (std::exception &exc)
+  {
+    std::cerr << std::endl << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    std::cerr << "Exception on processing: " << std::endl
+    << exc.what() << std::endl
+    << "Aborting!" << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    return 1;
+  }
+  catch (...)
+  {
+    std::cerr << std::endl << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    std::cerr << "Unknown exception!" << std::endl
+    << "Aborting!" << std::endl
+    << "----------------------------------------------------"
+    << std::endl;
+    return 1;
+  }
+  return 0;
+}
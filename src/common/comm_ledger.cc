@@ -0,0 +1,102 @@
+#include <deal.II/base/utilities.h>
+
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#include "comm_ledger.h"
+
+CommLedger::CommLedger (MPI_Comm &mpi_communicator, std::string filename)
+:
+filename(filename),
+outer_iteration(0),
+mpi_communicator(mpi_communicator)
+{
+}
+
+CommLedger::~CommLedger ()
+{
+}
+
+bool CommLedger::is_enabled ()
+{
+  return filename!="";
+}
+
+void CommLedger::set_outer_iteration (unsigned int outer_iteration)
+{
+  this->outer_iteration = outer_iteration;
+}
+
+void CommLedger::record (std::string phase_name, std::string kind,
+                         double count, double bytes)
+{
+  if (!is_enabled ())
+    return;
+  std::pair<double, double> &entry =
+  entries[std::make_pair (outer_iteration, std::make_pair (phase_name, kind))];
+  entry.first += count;
+  entry.second += bytes;
+}
+
+void CommLedger::print (ConditionalOStream &pcout)
+{
+  if (!is_enabled ())
+    return;
+  // every process books the same entries since they all take part in the
+  // same exchanges, so the maps can be reduced entry by entry
+  const double mb = 1024.0 * 1024.0;
+  std::map<std::pair<std::string, std::string>, std::vector<double> > by_phase;
+  std::map<unsigned int, std::vector<double> > by_outer_iteration;
+  std::ofstream out;
+  if (Utilities::MPI::this_mpi_process (mpi_communicator)==0)
+  {
+    out.open (filename.c_str ());
+    out << "outer_iter,phase,kind,count,bytes_sum,bytes_max" << std::endl;
+  }
+  for (std::map<EntryKey, std::pair<double, double> >::iterator it=entries.begin ();
+       it!=entries.end (); ++it)
+  {
+    double bytes_sum = Utilities::MPI::sum (it->second.second, mpi_communicator);
+    double bytes_max = Utilities::MPI::max (it->second.second, mpi_communicator);
+    if (out.is_open ())
+      out << it->first.first << "," << it->first.second.first << ","
+      << it->first.second.second << "," << it->second.first << ","
+      << bytes_sum << "," << bytes_max << "\n";
+    std::vector<double> &phase = by_phase[it->first.second];
+    phase.resize (3, 0.0);
+    phase[0] += it->second.first;
+    phase[1] += bytes_sum;
+    phase[2] += bytes_max;
+    std::vector<double> &outer = by_outer_iteration[it->first.first];
+    outer.resize (2, 0.0);
+    outer[0] += it->second.first;
+    outer[1] += bytes_sum;
+  }
+  out.close ();
+
+  pcout << "Communication ledger (counts per process, MB summed over processes)"
+  << std::endl;
+  pcout << std::setw(28) << std::left << "phase"
+  << std::setw(34) << "exchange"
+  << std::setw(12) << std::right << "count"
+  << std::setw(14) << "MB"
+  << std::setw(16) << "max MB/proc" << std::endl;
+  for (std::map<std::pair<std::string, std::string>, std::vector<double> >::iterator
+       it=by_phase.begin (); it!=by_phase.end (); ++it)
+    pcout << std::setw(28) << std::left << it->first.first
+    << std::setw(34) << it->first.second
+    << std::setw(12) << std::right << std::fixed << std::setprecision(0) << it->second[0]
+    << std::setw(14) << std::setprecision(3) << it->second[1] / mb
+    << std::setw(16) << it->second[2] / mb << std::endl;
+  pcout << std::endl << std::setw(28) << std::left << "outer iteration"
+  << std::setw(12) << std::right << "count"
+  << std::setw(14) << "MB" << std::endl;
+  for (std::map<unsigned int, std::vector<double> >::iterator
+       it=by_outer_iteration.begin (); it!=by_outer_iteration.end (); ++it)
+    pcout << std::setw(28) << std::left << it->first
+    << std::setw(12) << std::right << std::setprecision(0) << it->second[0]
+    << std::setw(14) << std::setprecision(3) << it->second[1] / mb << std::endl;
+  pcout.get_stream().unsetf (std::ios_base::floatfield);
+  pcout << std::endl;
+}
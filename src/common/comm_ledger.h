@@ -0,0 +1,43 @@
+#ifndef __comm_ledger_h__
+#define __comm_ledger_h__
+
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/mpi.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+using namespace dealii;
+
+// Ledger of the MPI traffic the solver triggers. Every entry is booked under
+// the current outer (power) iteration, a phase and a kind of exchange, e.g.
+// "vector compress" or "norm reduction", with the bytes this process sends
+// or receives. Byte counts of compress and halo exchanges are estimates from
+// the mesh partition, reductions are exact.
+class CommLedger
+{
+public:
+  // an empty file name disables the ledger
+  CommLedger (MPI_Comm &mpi_communicator, std::string filename);
+  ~CommLedger ();
+
+  bool is_enabled ();
+  void set_outer_iteration (unsigned int outer_iteration);
+  void record (std::string phase_name, std::string kind,
+               double count, double bytes);
+  // collective: reduces the ledger, prints a summary and writes the CSV file
+  void print (ConditionalOStream &pcout);
+
+private:
+  typedef std::pair<unsigned int, std::pair<std::string, std::string> > EntryKey;
+
+  std::string filename;
+  unsigned int outer_iteration;
+  // count and bytes per (outer iteration, phase, kind)
+  std::map<EntryKey, std::pair<double, double> > entries;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__comm_ledger_h__
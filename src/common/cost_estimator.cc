@@ -0,0 +1,270 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/multithread_info.h>
+
+#include <petscsys.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "cost_estimator.h"
+#include "../aqdata/aq_lsgc.h"
+
+CostEstimator::CostEstimator (ParameterHandler &prm)
+:
+dim(prm.get_integer("problem dimension")),
+p_order(prm.get_integer("finite element polynomial degree")),
+n_azi(prm.get_integer("angular quadrature order")),
+n_group(prm.get_integer("number of groups")),
+global_refinements(prm.get_integer("uniform refinements")),
+do_nda(prm.get_bool("do NDA")),
+discretization(prm.get("spatial discretization")),
+ho_linear_solver_name(prm.get("HO linear solver name")),
+ho_preconditioner_name(prm.get("HO preconditioner name"))
+{
+  AssertThrow (dim==2 || dim==3,
+               ExcMessage ("only 2D and 3D problems can be estimated"));
+  if (dim==2)
+    count_directions<2> (prm);
+  else
+    count_directions<3> (prm);
+  count_cells (prm);
+  count_dofs_and_nonzeros ();
+}
+
+CostEstimator::~CostEstimator ()
+{
+}
+
+template <int dim>
+void CostEstimator::count_directions (ParameterHandler &prm)
+{
+  // the quadrature is cheap to build, so use the real one rather than
+  // repeating its direction count formula
+  AQLSGC<dim> aq (prm);
+  aq.make_aq (prm);
+  n_dir = aq.get_n_dir ();
+  n_total_ho_vars = aq.get_n_total_ho_vars ();
+}
+
+void CostEstimator::count_cells (ParameterHandler &prm)
+{
+  const double refinement_factor = std::pow (2.0, 1.0 * dim * global_refinements);
+  if (prm.get_bool ("is mesh generated by deal.II"))
+  {
+    std::vector<int> ncell_per_dir = Utilities::string_to_int
+    (Utilities::split_string_list (prm.get ("number of cells for x, y, z directions")));
+    AssertThrow (ncell_per_dir.size ()>=dim,
+                 ExcMessage ("need a number of cells for every direction"));
+    n_cells = 1.0;
+    for (unsigned int d=0; d<dim; ++d)
+    {
+      cells_per_dir.push_back (ncell_per_dir[d] * std::pow (2.0, 1.0 * global_refinements));
+      n_cells *= cells_per_dir[d];
+    }
+    cell_source = "generated mesh";
+    return;
+  }
+
+  // gmsh 2.2: count quadrilaterals (type 3) or hexahedra (type 5)
+  std::string mesh_filename = prm.get ("mesh file name");
+  std::ifstream in (mesh_filename.c_str ());
+  AssertThrow (in.is_open (),
+               ExcMessage ("cannot open mesh file " + mesh_filename));
+  std::string line;
+  while (std::getline (in, line) && line.find ("$Elements")==std::string::npos)
+    ;
+  unsigned int n_elements = 0, n_coarse_cells = 0;
+  in >> n_elements;
+  for (unsigned int i=0; i<n_elements; ++i)
+  {
+    unsigned int id, type;
+    in >> id >> type;
+    std::getline (in, line);
+    if ((dim==2 && type==3) || (dim==3 && type==5))
+      ++n_coarse_cells;
+  }
+  n_cells = n_coarse_cells * refinement_factor;
+  // unstructured meshes are counted as a cube with the same number of cells
+  cells_per_dir.resize (dim, std::pow (n_cells, 1.0 / dim));
+  cell_source = mesh_filename;
+}
+
+void CostEstimator::count_dofs_and_nonzeros ()
+{
+  const double dofs_per_cell = std::pow (p_order + 1.0, 1.0 * dim);
+  if (discretization=="dfem")
+  {
+    // every cell couples to itself and to its face neighbors
+    double n_interior_faces = 0.0;
+    for (unsigned int d=0; d<dim; ++d)
+      n_interior_faces += n_cells / cells_per_dir[d] * (cells_per_dir[d] - 1.0);
+    n_dofs = n_cells * dofs_per_cell;
+    nnz_per_matrix = (n_cells + 2.0 * n_interior_faces) * dofs_per_cell * dofs_per_cell;
+  }
+  else
+  {
+    // Q_p on a brick: two dofs couple iff they share a cell in every
+    // direction, so DoFs and nonzeros are products of 1D counts
+    n_dofs = 1.0;
+    nnz_per_matrix = 1.0;
+    for (unsigned int d=0; d<dim; ++d)
+    {
+      n_dofs *= cells_per_dir[d] * p_order + 1.0;
+      nnz_per_matrix *= (cells_per_dir[d] * (p_order + 1.0) * (p_order + 1.0) -
+                         (cells_per_dir[d] - 1.0));
+    }
+  }
+}
+
+double CostEstimator::get_preconditioner_bytes ()
+{
+  const double entry = sizeof (PetscScalar) + sizeof (PetscInt);
+  const double matrix_bytes = nnz_per_matrix * entry;
+  if (ho_linear_solver_name=="direct")
+  {
+    // nested dissection fill of the MUMPS factors, scaled by the coupling
+    // density relative to a 5-/7-point stencil; a rough figure
+    double coupling = nnz_per_matrix / n_dofs / (dim==2 ? 5.0 : 7.0);
+    double nnz_factor = (dim==2 ?
+                         8.0 * n_dofs * std::log (n_dofs) / std::log (2.0) :
+                         30.0 * std::pow (n_dofs, 4.0 / 3.0)) * coupling;
+    return nnz_factor * entry;
+  }
+  // "auto" is sized like AMG, the largest of the iterative choices
+  if (ho_preconditioner_name=="amg" || ho_preconditioner_name=="auto")
+    // BoomerAMG operator complexity is typically 1.5-2.5 for these systems
+    return 2.0 * matrix_bytes;
+  if (ho_preconditioner_name=="parasails" || ho_preconditioner_name=="bjacobi")
+    return matrix_bytes;
+  if (ho_preconditioner_name=="bssor")
+    return 2.0 * n_dofs * sizeof (PetscScalar);
+  return n_dofs * sizeof (PetscScalar);
+}
+
+void CostEstimator::print_estimate (double node_memory,
+                                    unsigned int cores_per_node,
+                                    std::ostream &out)
+{
+  const double mb = 1024.0 * 1024.0;
+  const double entry = sizeof (PetscScalar) + sizeof (PetscInt);
+  const double n_matrices = n_total_ho_vars + (do_nda ? n_group : 0);
+  const double n_q = std::pow (p_order + 1.0, 1.0 * dim);
+  const double dofs_per_cell = std::pow (p_order + 1.0, 1.0 * dim);
+
+  // distributed over processes
+  std::vector<std::pair<std::string, double> > distributed;
+  distributed.push_back (std::make_pair ("HO system matrices",
+                                         n_matrices * (nnz_per_matrix * entry +
+                                                       3.0 * n_dofs * sizeof (PetscInt))));
+  distributed.push_back (std::make_pair ("preconditioners/factors",
+                                         n_total_ho_vars * get_preconditioner_bytes ()));
+  distributed.push_back (std::make_pair ("HO vectors (aflx, rhs, fixed rhs)",
+                                         3.0 * n_total_ho_vars * n_dofs * sizeof (double)));
+  distributed.push_back (std::make_pair ("scalar flux vectors",
+                                         (3.0 + (do_nda ? 5.0 : 0.0)) * n_group *
+                                         n_dofs * sizeof (double)));
+  distributed.push_back (std::make_pair ("test functions at qp",
+                                         n_cells * n_q * dofs_per_cell * sizeof (double)));
+  distributed.push_back (std::make_pair ("scalar fluxes at qp",
+                                         n_cells * n_group * n_q * sizeof (double)));
+  distributed.push_back (std::make_pair ("triangulation and DoF handler",
+                                         n_cells * 1024.0));
+  // replicated on every process
+  std::vector<std::pair<std::string, double> > replicated;
+  replicated.push_back (std::make_pair ("sflx_proc replicas",
+                                        (2.0 + (do_nda ? 1.0 : 0.0)) * n_group *
+                                        n_dofs * sizeof (double)));
+  replicated.push_back (std::make_pair ("MPI/PETSc runtime", 100.0 * mb));
+
+  double total_distributed = 0.0, total_replicated = 0.0;
+  for (unsigned int i=0; i<distributed.size(); ++i)
+    total_distributed += distributed[i].second;
+  for (unsigned int i=0; i<replicated.size(); ++i)
+    total_replicated += replicated[i].second;
+
+  // fewest nodes first, then as many ranks as fit
+  unsigned int best_ranks = 0, best_nodes = 0, best_ranks_per_node = 0;
+  for (unsigned int r=cores_per_node; r>0; --r)
+  {
+    double budget = 0.8 * node_memory / r - total_replicated;
+    if (budget<=0.0)
+      continue;
+    unsigned int ranks = std::max (1.0, std::ceil (total_distributed / budget));
+    unsigned int nodes = (ranks + r - 1) / r;
+    ranks = nodes * r;
+    if (best_nodes==0 || nodes<best_nodes)
+    {
+      best_ranks = ranks;
+      best_nodes = nodes;
+      best_ranks_per_node = r;
+    }
+  }
+
+  out << "Estimate for " << dim << "D " << discretization << " Q" << p_order
+  << ", S" << n_azi << ", " << n_group << " group(s)" << std::endl;
+  out << std::setw(40) << std::left << "cells (" + cell_source + ")"
+  << std::setw(16) << std::right << std::setprecision(0) << std::fixed << n_cells << std::endl;
+  out << std::setw(40) << std::left << "DoFs per component"
+  << std::setw(16) << std::right << n_dofs << std::endl;
+  out << std::setw(40) << std::left << "directions"
+  << std::setw(16) << std::right << n_dir << std::endl;
+  out << std::setw(40) << std::left << "HO components"
+  << std::setw(16) << std::right << n_total_ho_vars << std::endl;
+  out << std::setw(40) << std::left << "HO unknowns"
+  << std::setw(16) << std::right << n_dofs * n_total_ho_vars << std::endl;
+  out << std::setw(40) << std::left << "nonzeros per matrix"
+  << std::setw(16) << std::right << nnz_per_matrix << std::endl;
+  out << std::setw(40) << std::left << "nonzeros, all matrices"
+  << std::setw(16) << std::right << nnz_per_matrix * n_matrices << std::endl;
+  out << std::endl << std::setprecision(1);
+  out << std::setw(40) << std::left << "memory (MB)"
+  << std::setw(16) << std::right << "total"
+  << std::setw(16) << "per process" << std::endl;
+  for (unsigned int i=0; i<distributed.size(); ++i)
+    out << std::setw(40) << std::left << distributed[i].first
+    << std::setw(16) << std::right << distributed[i].second / mb
+    << std::setw(16) << (best_ranks>0 ? distributed[i].second / mb / best_ranks : 0.0)
+    << std::endl;
+  for (unsigned int i=0; i<replicated.size(); ++i)
+    out << std::setw(40) << std::left << replicated[i].first + " (each)"
+    << std::setw(16) << std::right << "-"
+    << std::setw(16) << replicated[i].second / mb << std::endl;
+  out << std::endl;
+  if (best_ranks==0)
+    out << "Replicated data alone exceeds 80% of "
+    << node_memory / mb / 1024.0 << " GB per node; this deck does not fit." << std::endl;
+  else
+    out << "Recommended: " << best_ranks << " processes on "
+    << best_nodes << " node(s) with " << best_ranks_per_node
+    << " processes each (" << node_memory / mb / 1024.0 << " GB, "
+    << cores_per_node << " cores per node), "
+    << (total_distributed / best_ranks + total_replicated) / mb
+    << " MB per process." << std::endl;
+  out.unsetf (std::ios_base::floatfield);
+}
+
+double CostEstimator::get_machine_memory ()
+{
+  std::ifstream meminfo ("/proc/meminfo");
+  std::string name;
+  double kb = 0.0;
+  while (meminfo >> name)
+  {
+    if (name=="MemTotal:")
+    {
+      meminfo >> kb;
+      break;
+    }
+    std::getline (meminfo, name);
+  }
+  return 1024.0 * kb;
+}
+
+unsigned int CostEstimator::get_machine_cores ()
+{
+  return std::max (1u, MultithreadInfo::n_cores ());
+}
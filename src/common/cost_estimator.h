@@ -0,0 +1,57 @@
+#ifndef __cost_estimator_h__
+#define __cost_estimator_h__
+
+#include <deal.II/base/parameter_handler.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace dealii;
+
+// Dry-run estimate of problem size and memory of an input deck. Nothing is
+// meshed or assembled: cell counts come from the deck or the .msh header,
+// DoFs and nonzeros from the FE type on a structured grid, and directions
+// from the angular quadrature itself. Memory figures are per process and
+// assume PETSc AIJ matrices.
+class CostEstimator
+{
+public:
+  CostEstimator (ParameterHandler &prm);
+  ~CostEstimator ();
+
+  // node memory in bytes; a rank count is recommended s.t. the estimate
+  // fits into 80% of it
+  void print_estimate (double node_memory, unsigned int cores_per_node,
+                       std::ostream &out);
+
+  // defaults for the node taken from the machine running the estimate
+  static double get_machine_memory ();
+  static unsigned int get_machine_cores ();
+
+private:
+  template <int dim> void count_directions (ParameterHandler &prm);
+  void count_cells (ParameterHandler &prm);
+  void count_dofs_and_nonzeros ();
+  double get_preconditioner_bytes ();
+
+  unsigned int dim;
+  unsigned int p_order;
+  unsigned int n_azi;
+  unsigned int n_group;
+  unsigned int n_dir;
+  unsigned int n_total_ho_vars;
+  unsigned int global_refinements;
+  bool do_nda;
+  std::string discretization;
+  std::string ho_linear_solver_name;
+  std::string ho_preconditioner_name;
+  std::string cell_source;
+
+  double n_cells;
+  std::vector<double> cells_per_dir;
+  double n_dofs;
+  double nnz_per_matrix;
+};
+
+#endif //__cost_estimator_h__
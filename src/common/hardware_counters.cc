@@ -0,0 +1,213 @@
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/utilities.h>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <stdint.h>
+#endif
+
+#include "hardware_counters.h"
+
+HardwareCounters::HardwareCounters (MPI_Comm &mpi_communicator, bool is_enabled,
+                                    unsigned int n_threads)
+:
+is_enabled(is_enabled),
+covers_all_threads(true),
+fds(n_events, -1),
+flop_weights(n_events, 0.0),
+mpi_communicator(mpi_communicator)
+{
+  flop_weights[fp_scalar_double] = 1.0;
+  flop_weights[fp_128b_packed_double] = 2.0;
+  flop_weights[fp_256b_packed_double] = 4.0;
+  flop_weights[fp_512b_packed_double] = 8.0;
+  if (is_enabled)
+  {
+    // inherited counters only follow threads started after the open; with a
+    // thread limit of one, deal.II has not started any worker yet
+    covers_all_threads = (n_threads<=1 || MultithreadInfo::n_threads ()==1);
+    open_events ();
+  }
+}
+
+HardwareCounters::~HardwareCounters ()
+{
+#ifdef __linux__
+  for (unsigned int i=0; i<fds.size(); ++i)
+    if (fds[i]>=0)
+      close (fds[i]);
+#endif
+}
+
+void HardwareCounters::open_events ()
+{
+#ifdef __linux__
+  // FP_ARITH_INST_RETIRED umasks; the raw encoding is only meaningful on
+  // Intel cores from Haswell on
+  bool is_intel = false;
+  {
+    std::ifstream cpuinfo ("/proc/cpuinfo");
+    std::string line;
+    while (std::getline (cpuinfo, line))
+      if (line.find ("GenuineIntel")!=std::string::npos)
+      {
+        is_intel = true;
+        break;
+      }
+  }
+  const unsigned int fp_umasks[4] = {0x01, 0x04, 0x10, 0x40};
+
+  for (unsigned int i=0; i<n_events; ++i)
+  {
+    struct perf_event_attr attr;
+    std::memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // also count the worker threads of the pipelined setup and sweeps
+    attr.inherit = 1;
+    // more events than hardware counters get multiplexed; the enabled and
+    // running times are used to scale the counts
+    attr.read_format = (PERF_FORMAT_TOTAL_TIME_ENABLED |
+                        PERF_FORMAT_TOTAL_TIME_RUNNING);
+    if (i==cycles || i==instructions || i==llc_misses)
+    {
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = (i==cycles ? PERF_COUNT_HW_CPU_CYCLES :
+                     (i==instructions ? PERF_COUNT_HW_INSTRUCTIONS :
+                      PERF_COUNT_HW_CACHE_MISSES));
+    }
+    else if (is_intel)
+    {
+      attr.type = PERF_TYPE_RAW;
+      attr.config = (fp_umasks[i-fp_scalar_double] << 8) | 0xC7;
+    }
+    else
+      continue;
+    fds[i] = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+#endif
+}
+
+std::vector<double> HardwareCounters::read_event (unsigned int event)
+{
+  std::vector<double> values (3, 0.0);
+#ifdef __linux__
+  if (fds[event]>=0)
+  {
+    uint64_t buffer[3];
+    if (read (fds[event], buffer, sizeof (buffer))==sizeof (buffer))
+      for (unsigned int i=0; i<3; ++i)
+        values[i] = buffer[i];
+  }
+#endif
+  return values;
+}
+
+void HardwareCounters::start (std::string phase_name)
+{
+  if (!is_enabled)
+    return;
+  if (phases.find (phase_name)==phases.end ())
+  {
+    phases[phase_name] = PhaseCounts ();
+    phase_order.push_back (phase_name);
+  }
+  std::vector<std::vector<double> > &values = start_values[phase_name];
+  values.resize (n_events);
+  for (unsigned int i=0; i<n_events; ++i)
+    values[i] = read_event (i);
+  start_times[phase_name] = MPI_Wtime ();
+}
+
+void HardwareCounters::stop (std::string phase_name)
+{
+  if (!is_enabled)
+    return;
+  PhaseCounts &phase = phases[phase_name];
+  phase.wall_time += MPI_Wtime () - start_times[phase_name];
+  phase.n_calls += 1;
+  for (unsigned int i=0; i<n_events; ++i)
+  {
+    std::vector<double> end_value = read_event (i);
+    std::vector<double> &start_value = start_values[phase_name][i];
+    double running = end_value[2] - start_value[2];
+    if (running>0.0)
+      phase.counts[i] += ((end_value[0] - start_value[0]) *
+                          (end_value[1] - start_value[1]) / running);
+  }
+}
+
+void HardwareCounters::print (ConditionalOStream &pcout)
+{
+  if (!is_enabled)
+    return;
+  // an event counts as available only if every process could open it
+  std::vector<bool> is_available (n_events);
+  for (unsigned int i=0; i<n_events; ++i)
+    is_available[i] = Utilities::MPI::min ((fds[i]>=0 && covers_all_threads ? 1 : 0),
+                                           mpi_communicator)==1;
+  bool have_flops = (is_available[fp_scalar_double] &&
+                     is_available[fp_128b_packed_double] &&
+                     is_available[fp_256b_packed_double] &&
+                     is_available[fp_512b_packed_double]);
+
+  // memory traffic is estimated as LLC misses times the cache line size;
+  // hardware prefetches that hit are not counted, so it is a lower bound
+  const double cache_line = 64.0;
+  pcout << "Hardware counters (sum over processes, max wall time)" << std::endl;
+  if (!covers_all_threads)
+    pcout << "  counters opened after worker threads were started, "
+    << "only wall times are reported" << std::endl;
+  pcout << std::setw(28) << std::left << "phase"
+  << std::setw(8) << std::right << "calls"
+  << std::setw(12) << "time (s)"
+  << std::setw(8) << "IPC"
+  << std::setw(14) << "LLC misses"
+  << std::setw(12) << "GB/s"
+  << std::setw(12) << "GFLOP/s"
+  << std::setw(12) << "FLOP/byte" << std::endl;
+  for (unsigned int p=0; p<phase_order.size(); ++p)
+  {
+    PhaseCounts &phase = phases[phase_order[p]];
+    double wall_time = Utilities::MPI::max (phase.wall_time, mpi_communicator);
+    std::vector<double> counts (n_events);
+    for (unsigned int i=0; i<n_events; ++i)
+      counts[i] = Utilities::MPI::sum (phase.counts[i], mpi_communicator);
+    double flops = 0.0;
+    for (unsigned int i=fp_scalar_double; i<n_events; ++i)
+      flops += flop_weights[i] * counts[i];
+    double bytes = counts[llc_misses] * cache_line;
+
+    pcout << std::setw(28) << std::left << phase_order[p]
+    << std::setw(8) << std::right << phase.n_calls
+    << std::fixed << std::setprecision(3)
+    << std::setw(12) << wall_time;
+    if (is_available[cycles] && is_available[instructions] && counts[cycles]>0.0)
+      pcout << std::setw(8) << std::setprecision(2) << counts[instructions] / counts[cycles];
+    else
+      pcout << std::setw(8) << "n/a";
+    if (is_available[llc_misses])
+      pcout << std::setw(14) << std::scientific << std::setprecision(3) << counts[llc_misses]
+      << std::fixed << std::setw(12) << (wall_time>0.0 ? bytes / wall_time * 1.0e-9 : 0.0);
+    else
+      pcout << std::setw(14) << "n/a" << std::setw(12) << "n/a";
+    if (have_flops)
+      pcout << std::setw(12) << (wall_time>0.0 ? flops / wall_time * 1.0e-9 : 0.0);
+    else
+      pcout << std::setw(12) << "n/a";
+    if (have_flops && is_available[llc_misses] && bytes>0.0)
+      pcout << std::setw(12) << flops / bytes;
+    else
+      pcout << std::setw(12) << "n/a";
+    pcout << std::endl;
+  }
+  pcout.get_stream().unsetf (std::ios_base::floatfield);
+  pcout << std::endl;
+}
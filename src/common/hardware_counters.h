@@ -0,0 +1,71 @@
+#ifndef __hardware_counters_h__
+#define __hardware_counters_h__
+
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/mpi.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace dealii;
+
+// Hardware counters read through Linux perf_event_open around named phases.
+// Counted per process for the calling thread and the threads it starts
+// later on: cycles, instructions, last level cache misses and, on Intel CPUs,
+// retired double precision FP instructions weighted by vector width.
+// Counters the kernel or CPU does not provide are reported as n/a; on other
+// platforms nothing is counted. Worker threads started before the counters
+// are opened are missed, so threaded runs then report every counter as n/a.
+class HardwareCounters
+{
+public:
+  HardwareCounters (MPI_Comm &mpi_communicator, bool is_enabled,
+                    unsigned int n_threads);
+  ~HardwareCounters ();
+
+  void start (std::string phase_name);
+  void stop (std::string phase_name);
+  void print (ConditionalOStream &pcout);
+
+private:
+  enum Event
+  {
+    cycles,
+    instructions,
+    llc_misses,
+    fp_scalar_double,
+    fp_128b_packed_double,
+    fp_256b_packed_double,
+    fp_512b_packed_double,
+    n_events
+  };
+
+  struct PhaseCounts
+  {
+    PhaseCounts () : counts (n_events, 0.0), wall_time (0.0), n_calls (0) {}
+    std::vector<double> counts;
+    double wall_time;
+    unsigned int n_calls;
+  };
+
+  void open_events ();
+  // raw value, time enabled and time running of an event
+  std::vector<double> read_event (unsigned int event);
+
+  bool is_enabled;
+  // false if worker threads may have been running before open_events
+  bool covers_all_threads;
+  std::vector<int> fds;
+  std::vector<double> flop_weights;
+
+  std::map<std::string, std::vector<std::vector<double> > > start_values;
+  std::map<std::string, double> start_times;
+  std::map<std::string, PhaseCounts> phases;
+  // phases are printed in the order they were first started
+  std::vector<std::string> phase_order;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__hardware_counters_h__
@@ -9,8 +9,13 @@
 //#include <deal.II/base/utilities.h>
 #include <deal.II/base/mpi.h>
 
+#include <cstdlib>
+#include <string>
+#include <vector>
+
 #include "problem_definition.h"
 #include "model_manager.h"
+#include "cost_estimator.h"
 
 using namespace dealii;
 
@@ -20,9 +25,63 @@ int main(int argc, char *argv[])
   {
     using namespace dealii;
     
+    if (argc>2 && std::string(argv[1])=="--estimate")
+    {
+      // dry run: sizes and memory of the deck without meshing or assembling
+      ParameterHandler prm;
+      ProblemDefinition::declare_parameters (prm);
+      prm.read_input(argv[2]);
+      double node_memory = CostEstimator::get_machine_memory ();
+      unsigned int cores_per_node = CostEstimator::get_machine_cores ();
+      for (int i=3; i<argc-1; i+=2)
+      {
+        std::string option (argv[i]);
+        if (option=="--node-memory")
+          node_memory = std::atof (argv[i+1]) * 1024.0 * 1024.0 * 1024.0;
+        else if (option=="--cores-per-node")
+          cores_per_node = std::atoi (argv[i+1]);
+        else
+          AssertThrow (false, ExcMessage ("unknown option " + option));
+      }
+      Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+      CostEstimator estimator (prm);
+      estimator.print_estimate (node_memory, cores_per_node, std::cout);
+      return 0;
+    }
+    if (argc>2 && std::string(argv[1])=="--batch")
+    {
+      // one case per deck, later decks only list what differs from the first
+      std::vector<std::string> deck_names (argv + 2, argv + argc);
+      ParameterHandler prm;
+      ProblemDefinition::declare_parameters (prm);
+      prm.read_input(argv[2]);
+      Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+      ModelManager modeler (prm);
+      modeler.run_batch (deck_names);
+      return 0;
+    }
+    if (argc>3 && std::string(argv[1])=="--ensemble")
+    {
+      // the decks are spread over the given number of process groups
+      unsigned int n_sub_comms = std::atoi (argv[2]);
+      std::vector<std::string> deck_names (argv + 3, argv + argc);
+      ParameterHandler prm;
+      ProblemDefinition::declare_parameters (prm);
+      prm.read_input(argv[3]);
+      Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+      ModelManager modeler (prm);
+      modeler.run_ensemble (deck_names, n_sub_comms);
+      return 0;
+    }
     if (argc!=2)
     {
       std::cerr << "Call the program as mpirun -np num_proc xtrans input_file_name" << std::endl;
+      std::cerr << "or as xtrans --estimate input_file_name [--node-memory GB] [--cores-per-node N]"
+      << std::endl;
+      std::cerr << "or as mpirun -np num_proc xtrans --batch input_file_name [case_file_name ...]"
+      << std::endl;
+      std::cerr << "or as mpirun -np num_proc xtrans --ensemble num_groups input_file_name [case_file_name ...]"
+      << std::endl;
       return 1;
     }
     ParameterHandler prm;
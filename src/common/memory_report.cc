@@ -0,0 +1,84 @@
+#include <deal.II/base/utilities.h>
+
+#include <iomanip>
+
+#include "memory_report.h"
+
+MemoryReport::MemoryReport (MPI_Comm &mpi_communicator)
+:
+mpi_communicator(mpi_communicator)
+{
+}
+
+MemoryReport::~MemoryReport ()
+{
+}
+
+void MemoryReport::clear ()
+{
+  entries.clear ();
+}
+
+void MemoryReport::add_entry (std::string entry_name, double bytes)
+{
+  entries.push_back (std::make_pair (entry_name, bytes));
+}
+
+void MemoryReport::print (std::string stage_name, ConditionalOStream &pcout)
+{
+  // every rank has to take part in the reductions even though only rank 0
+  // prints the table
+  const double mb = 1024.0 * 1024.0;
+  double total = 0.0;
+  pcout << "Memory report: " << stage_name << std::endl;
+  pcout << std::setw(36) << std::left << "entry"
+  << std::setw(14) << std::right << "min (MB)"
+  << std::setw(14) << "max (MB)"
+  << std::setw(14) << "avg (MB)" << std::endl;
+  for (unsigned int i=0; i<entries.size(); ++i)
+  {
+    Utilities::MPI::MinMaxAvg stat =
+    Utilities::MPI::min_max_avg (entries[i].second / mb, mpi_communicator);
+    pcout << std::setw(36) << std::left << entries[i].first
+    << std::fixed << std::setprecision(3)
+    << std::setw(14) << std::right << stat.min
+    << std::setw(14) << stat.max
+    << std::setw(14) << stat.avg << std::endl;
+    total += entries[i].second;
+  }
+  Utilities::MPI::MinMaxAvg stat =
+  Utilities::MPI::min_max_avg (total / mb, mpi_communicator);
+  pcout << std::setw(36) << std::left << "sum of entries above"
+  << std::setw(14) << std::right << stat.min
+  << std::setw(14) << stat.max
+  << std::setw(14) << stat.avg << std::endl;
+
+  // process-level usage is reported separately since it also accounts for
+  // memory owned by PETSc, hypre and MUMPS
+  stat = Utilities::MPI::min_max_avg (get_current_rss () / mb, mpi_communicator);
+  pcout << std::setw(36) << std::left << "process RSS"
+  << std::setw(14) << std::right << stat.min
+  << std::setw(14) << stat.max
+  << std::setw(14) << stat.avg << std::endl;
+  stat = Utilities::MPI::min_max_avg (get_peak_rss () / mb, mpi_communicator);
+  pcout << std::setw(36) << std::left << "process peak RSS"
+  << std::setw(14) << std::right << stat.min
+  << std::setw(14) << stat.max
+  << std::setw(14) << stat.avg << std::endl;
+  pcout.get_stream().unsetf (std::ios_base::floatfield);
+  pcout << std::endl;
+}
+
+double MemoryReport::get_current_rss ()
+{
+  Utilities::System::MemoryStats stats;
+  Utilities::System::get_memory_stats (stats);
+  return 1024.0 * stats.VmRSS;
+}
+
+double MemoryReport::get_peak_rss ()
+{
+  Utilities::System::MemoryStats stats;
+  Utilities::System::get_memory_stats (stats);
+  return 1024.0 * stats.VmHWM;
+}
@@ -0,0 +1,35 @@
+#ifndef __memory_report_h__
+#define __memory_report_h__
+
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/mpi.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dealii;
+
+class MemoryReport
+{
+public:
+  MemoryReport (MPI_Comm &mpi_communicator);
+  ~MemoryReport ();
+
+  void clear ();
+  void add_entry (std::string entry_name, double bytes);
+  void print (std::string stage_name, ConditionalOStream &pcout);
+
+  // process-level memory in bytes read from /proc/self/status
+  static double get_current_rss ();
+  static double get_peak_rss ();
+
+private:
+  // entries are kept in insertion order s.t. reports from different stages
+  // line up with each other
+  std::vector<std::pair<std::string, double> > entries;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__memory_report_h__
@@ -1,12 +1,28 @@
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/utilities.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
 #include "model_manager.h"
+#include "problem_definition.h"
 #include "../transport/transport_base.h"
 #include "../transport/even_parity.h"
 
+// columns of the batch summary, the scalar flux norms of all groups last
+enum SummaryColumn {col_sub_comm, col_model_reused, col_operators_reused,
+  col_rom_solved, col_si_iters, col_has_keff, col_keff, col_time, col_phi};
 
 ModelManager::ModelManager (ParameterHandler &prm)
 :
 transport_model_name(prm.get("transport model")),
-dim(prm.get_integer("problem dimension"))
+dim(prm.get_integer("problem dimension")),
+n_group(prm.get_integer("number of groups"))
 {
   // register new methods here
   method_index["ep"] = 0;
@@ -21,25 +37,308 @@ void ModelManager::build_and_run_model (ParameterHandler &prm)
   AssertThrow(dim!=1,
               ExcMessage("1D is not implemented"));
   
+  if (dim==2)
+    run_case<2> (prm, tb_2d, false, MPI_COMM_WORLD);
+  else
+    run_case<3> (prm, tb_3d, false, MPI_COMM_WORLD);
+}
+
+template <int dim>
+void ModelManager::run_case (ParameterHandler &prm,
+                             std_cxx11::shared_ptr<TransportBase<dim> > &tb,
+                             bool is_model_reused,
+                             MPI_Comm mpi_communicator)
+{
+  if (is_model_reused)
+  {
+    tb->run_next_case (prm);
+    run_summary = tb->get_run_summary ();
+    return;
+  }
+  // the previous model goes first so that two never coexist
+  tb.reset ();
   unsigned int mi = method_index[transport_model_name];
   switch (mi)
   {
     case 0:
-    {
-      if (dim==2)
-      {
-        std_cxx11::shared_ptr<TransportBase<2> > tb = std_cxx11::shared_ptr<TransportBase<2> > (new EvenParity<2>(prm));
-        tb->run ();
-      }
-      else
-      {
-        std_cxx11::shared_ptr<TransportBase<3> > tb = std_cxx11::shared_ptr<TransportBase<3> > (new EvenParity<3>(prm));
-        tb->run ();
-      }
-    }
+      tb = std_cxx11::shared_ptr<TransportBase<dim> > (new EvenParity<dim>(prm, mpi_communicator));
       break;
       
     default:
       break;
   }
+  tb->run ();
+  run_summary = tb->get_run_summary ();
+}
+
+std::string ModelManager::get_structure_signature (ParameterHandler &prm)
+{
+  // entries of the top level and the material ID map as printed by the
+  // handler; cross sections and sources live in the other subsections
+  std::set<std::string> per_case;
+  per_case.insert ("output file name base");
+  per_case.insert ("linear solver telemetry file name");
+  per_case.insert ("convergence history file name");
+  per_case.insert ("communication ledger file name");
+  per_case.insert ("operator cache directory");
+  per_case.insert ("HO preconditioner refresh threshold");
+  std::ostringstream printed;
+  prm.print_parameters (printed, ParameterHandler::Text);
+  std::istringstream lines (printed.str ());
+  std::ostringstream signature;
+  std::vector<std::string> subsections;
+  std::string line;
+  while (std::getline (lines, line))
+  {
+    line = line.substr (0, line.find ('#'));
+    std::size_t begin = line.find_first_not_of (' ');
+    if (begin==std::string::npos)
+      continue;
+    line = line.substr (begin);
+    if (line.compare (0, 11, "subsection ")==0)
+      subsections.push_back (line.substr (11));
+    else if (line.compare (0, 3, "end")==0 && subsections.size ()>0)
+      subsections.pop_back ();
+    else if (line.compare (0, 4, "set ")==0 &&
+             (subsections.size ()==0 ||
+              (subsections.size ()==1 && subsections[0].find ("material ID map")==0)))
+    {
+      std::string name = line.substr (4, line.find ('=') - 4);
+      name = name.substr (0, name.find_last_not_of (' ') + 1);
+      if (per_case.count (name)==0)
+        signature << line << "\n";
+    }
+  }
+  // same file names do not mean the same files
+  std::vector<std::string> filenames;
+  prm.enter_subsection ("material ID map");
+  filenames.push_back (prm.get ("material id file name"));
+  prm.leave_subsection ();
+  if (!prm.get_bool ("is mesh generated by deal.II"))
+    filenames.push_back (prm.get ("mesh file name"));
+  for (unsigned int i=0; i<filenames.size(); ++i)
+  {
+    std::ifstream in (filenames[i].c_str ());
+    signature << in.rdbuf ();
+  }
+  return signature.str ();
+}
+
+void ModelManager::run_batch (std::vector<std::string> &deck_names)
+{
+  AssertThrow(dim!=1,
+              ExcMessage("1D is not implemented"));
+  AssertThrow(deck_names.size ()>0,
+              ExcMessage("need at least one deck"));
+  std::vector<unsigned int> cases;
+  for (unsigned int i=0; i<deck_names.size(); ++i)
+    cases.push_back (i);
+  std::vector<std::vector<double> > rows (deck_names.size (),
+                                          std::vector<double> (col_phi + n_group, 0.0));
+  run_decks (deck_names, cases, 0, MPI_COMM_WORLD, rows);
+  ConditionalOStream pcout (std::cout,
+                            Utilities::MPI::this_mpi_process (MPI_COMM_WORLD)==0);
+  print_summary (deck_names, rows, false, pcout);
+}
+
+void ModelManager::run_ensemble (std::vector<std::string> &deck_names,
+                                 unsigned int n_sub_comms)
+{
+  AssertThrow(dim!=1,
+              ExcMessage("1D is not implemented"));
+  AssertThrow(deck_names.size ()>0,
+              ExcMessage("need at least one deck"));
+  const unsigned int n_procs = Utilities::MPI::n_mpi_processes (MPI_COMM_WORLD);
+  const unsigned int this_proc = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD);
+  AssertThrow(n_sub_comms>0 && n_sub_comms<=n_procs,
+              ExcMessage("need between 1 and the number of processes sub-communicators"));
+  // contiguous blocks of ranks, so that a sub-communicator stays on as few
+  // nodes as possible
+  unsigned int sub_comm = this_proc * n_sub_comms / n_procs;
+  MPI_Comm sub_communicator;
+  MPI_Comm_split (MPI_COMM_WORLD, sub_comm, this_proc, &sub_communicator);
+  
+  std::vector<unsigned int> cases;
+  for (unsigned int i=sub_comm; i<deck_names.size(); i+=n_sub_comms)
+    cases.push_back (i);
+  std::vector<std::vector<double> > rows (deck_names.size (),
+                                          std::vector<double> (col_phi + n_group, 0.0));
+  run_decks (deck_names, cases, sub_comm, sub_communicator, rows);
+  // the models hold PETSc objects on the sub-communicator
+  tb_2d.reset ();
+  tb_3d.reset ();
+  bool is_sub_comm_root = Utilities::MPI::this_mpi_process (sub_communicator)==0;
+  MPI_Comm_free (&sub_communicator);
+  
+  // only the first process of every sub-communicator contributes its rows
+  const unsigned int row_size = col_phi + n_group;
+  std::vector<double> local (deck_names.size () * row_size, 0.0);
+  if (is_sub_comm_root)
+    for (unsigned int i=0; i<cases.size(); ++i)
+      std::copy (rows[cases[i]].begin (), rows[cases[i]].end (),
+                 local.begin () + cases[i] * row_size);
+  std::vector<double> global (local.size (), 0.0);
+  MPI_Reduce (&local[0], &global[0], local.size (), MPI_DOUBLE, MPI_SUM,
+              0, MPI_COMM_WORLD);
+  for (unsigned int i=0; i<deck_names.size(); ++i)
+    std::copy (global.begin () + i * row_size, global.begin () + (i + 1) * row_size,
+               rows[i].begin ());
+  ConditionalOStream pcout (std::cout, this_proc==0);
+  print_summary (deck_names, rows, true, pcout);
+}
+
+void ModelManager::run_decks (std::vector<std::string> &deck_names,
+                              const std::vector<unsigned int> &cases,
+                              unsigned int sub_comm,
+                              MPI_Comm mpi_communicator,
+                              std::vector<std::vector<double> > &rows)
+{
+  ConditionalOStream pcout (std::cout,
+                            Utilities::MPI::this_mpi_process (mpi_communicator)==0);
+  // outputs of the cases are kept apart, also between the sub-communicators
+  // of an ensemble
+  std::vector<std::string> output_entries;
+  output_entries.push_back ("output file name base");
+  output_entries.push_back ("linear solver telemetry file name");
+  output_entries.push_back ("convergence history file name");
+  output_entries.push_back ("communication ledger file name");
+  std::string last_signature;
+  for (unsigned int c=0; c<cases.size(); ++c)
+  {
+    unsigned int i = cases[c];
+    Timer timer (mpi_communicator, true);
+    timer.start ();
+    // later decks only need the entries that differ from the first one
+    ParameterHandler prm;
+    ProblemDefinition::declare_parameters (prm);
+    prm.read_input (deck_names[0]);
+    std::vector<std::string> first_names;
+    for (unsigned int e=0; e<output_entries.size(); ++e)
+      first_names.push_back (prm.get (output_entries[e]));
+    if (i>0)
+      prm.read_input (deck_names[i]);
+    AssertThrow(prm.get_integer ("problem dimension")==dim &&
+                prm.get ("transport model")==transport_model_name &&
+                prm.get_integer ("number of groups")==n_group,
+                ExcMessage("decks of a batch need the same dimension, model and groups"));
+    // names a deck sets itself are left alone
+    for (unsigned int e=0; e<output_entries.size(); ++e)
+      if (i>0 && first_names[e]!="" &&
+          prm.get (output_entries[e])==first_names[e])
+        prm.set (output_entries[e], get_case_file_name (first_names[e], i));
+    std::string signature = get_structure_signature (prm);
+    bool is_model_reused = (c>0 && signature==last_signature);
+    last_signature = signature;
+    pcout << "Batch case " << i << ": " << deck_names[i]
+    << (is_model_reused ? " (reusing model)" : "") << std::endl;
+    if (dim==2)
+      run_case<2> (prm, tb_2d, is_model_reused, mpi_communicator);
+    else
+      run_case<3> (prm, tb_3d, is_model_reused, mpi_communicator);
+    timer.stop ();
+    
+    std::vector<double> &row = rows[i];
+    row[col_sub_comm] = sub_comm;
+    row[col_model_reused] = is_model_reused;
+    row[col_operators_reused] = run_summary["operators reused"];
+    row[col_rom_solved] = run_summary["ROM solve"];
+    row[col_si_iters] = run_summary["SI iterations"];
+    row[col_has_keff] = run_summary.count ("keff");
+    row[col_keff] = run_summary["keff"];
+    row[col_time] = timer.wall_time ();
+    for (unsigned int g=0; g<n_group; ++g)
+    {
+      std::ostringstream os;
+      os << "phi l1 norm (group " << g << ")";
+      row[col_phi + g] = run_summary[os.str ()];
+    }
+  }
+}
+
+std::string ModelManager::get_case_file_name (const std::string &name,
+                                              unsigned int i)
+{
+  // the suffix goes before the extension, if any
+  std::string suffix = "-case" + Utilities::int_to_string (i);
+  std::size_t dot = name.rfind ('.');
+  std::size_t slash = name.rfind ('/');
+  if (dot==std::string::npos || dot==0 ||
+      (slash!=std::string::npos && dot<slash + 2))
+    return name + suffix;
+  return name.substr (0, dot) + suffix + name.substr (dot);
+}
+
+void ModelManager::print_summary (std::vector<std::string> &deck_names,
+                                  std::vector<std::vector<double> > &rows,
+                                  bool is_ensemble,
+                                  ConditionalOStream &pcout)
+{
+  pcout << std::endl << (is_ensemble ? "Ensemble summary" : "Batch summary") << std::endl;
+  pcout << std::setw(6) << std::left << "case"
+  << std::setw(32) << "deck";
+  if (is_ensemble)
+    pcout << std::setw(6) << std::right << "comm" << std::setw(2) << "";
+  pcout << std::setw(8) << std::left << "model"
+  << std::setw(10) << "operators"
+  << std::setw(6) << "solve"
+  << std::setw(10) << std::right << "SI iters"
+  << std::setw(14) << "keff"
+  << std::setw(12) << "time (s)" << std::endl;
+  for (unsigned int i=0; i<deck_names.size(); ++i)
+  {
+    pcout << std::setw(6) << std::left << i
+    << std::setw(32) << deck_names[i];
+    if (is_ensemble)
+      pcout << std::setw(6) << std::right << rows[i][col_sub_comm] << std::setw(2) << "";
+    pcout << std::setw(8) << std::left << (rows[i][col_model_reused]>0.5 ? "reused" : "built")
+    << std::setw(10) << (rows[i][col_operators_reused]>0.5 ? "reused" : "built")
+    << std::setw(6) << (rows[i][col_rom_solved]>0.5 ? "ROM" : "full")
+    << std::setw(10) << std::right << rows[i][col_si_iters];
+    if (rows[i][col_has_keff]>0.5)
+      pcout << std::setw(14) << std::fixed << std::setprecision(8) << rows[i][col_keff];
+    else
+      pcout << std::setw(14) << "-";
+    pcout << std::setw(12) << std::fixed << std::setprecision(2) << rows[i][col_time]
+    << std::endl;
+    pcout.get_stream().unsetf (std::ios_base::floatfield);
+  }
+  pcout << std::endl;
+  if (!is_ensemble || deck_names.size ()<2)
+    return;
+  
+  // sample mean and standard deviation over the cases
+  std::vector<unsigned int> cols;
+  std::vector<std::string> names;
+  if (rows[0][col_has_keff]>0.5)
+  {
+    cols.push_back (col_keff);
+    names.push_back ("keff");
+  }
+  for (unsigned int g=0; g<n_group; ++g)
+  {
+    cols.push_back (col_phi + g);
+    names.push_back ("phi l1 norm (group " + Utilities::int_to_string (g) + ")");
+  }
+  const double n = deck_names.size ();
+  pcout << std::setw(28) << std::left << "quantity"
+  << std::setw(18) << std::right << "mean"
+  << std::setw(18) << "std. deviation" << std::endl;
+  for (unsigned int c=0; c<cols.size(); ++c)
+  {
+    double mean = 0.0, var = 0.0;
+    for (unsigned int i=0; i<deck_names.size(); ++i)
+      mean += rows[i][cols[c]] / n;
+    for (unsigned int i=0; i<deck_names.size(); ++i)
+      var += (rows[i][cols[c]] - mean) * (rows[i][cols[c]] - mean) / (n - 1.0);
+    pcout << std::setw(28) << std::left << names[c]
+    << std::setw(18) << std::right << std::scientific << std::setprecision(8) << mean
+    << std::setw(18) << std::sqrt (var) << std::endl;
+  }
+  pcout.get_stream().unsetf (std::ios_base::floatfield);
+  pcout << std::endl;
+}
+
+std::map<std::string, double> ModelManager::get_run_summary ()
+{
+  return run_summary;
 }
@@ -2,12 +2,18 @@
 #define __MODEL_MANAGER__H__
 
 #include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/std_cxx11/shared_ptr.h>
 
 #include <string>
 #include <map>
+#include <vector>
 
 using namespace dealii;
 
+template <int dim> class TransportBase;
+
 class ModelManager
 {
 public:
@@ -15,11 +21,47 @@ public:
   ~ModelManager ();
 
   void build_and_run_model (ParameterHandler &prm);
+  // runs every deck read on top of the first one; consecutive cases with the
+  // same mesh, discretization and angular quadrature share one model, so
+  // only materials, sources and file names should differ between decks
+  void run_batch (std::vector<std::string> &deck_names);
+  // splits MPI_COMM_WORLD into n_sub_comms groups of processes, which run the
+  // decks round robin as batches of their own; summaries and ensemble
+  // statistics are printed by the first process
+  void run_ensemble (std::vector<std::string> &deck_names,
+                     unsigned int n_sub_comms);
+  std::map<std::string, double> get_run_summary ();
 
 private:
+  template <int dim>
+  void run_case (ParameterHandler &prm,
+                 std_cxx11::shared_ptr<TransportBase<dim> > &tb,
+                 bool is_model_reused,
+                 MPI_Comm mpi_communicator);
+  // runs the listed cases in order on mpi_communicator and fills their rows
+  // of the summary table
+  void run_decks (std::vector<std::string> &deck_names,
+                  const std::vector<unsigned int> &cases,
+                  unsigned int sub_comm,
+                  MPI_Comm mpi_communicator,
+                  std::vector<std::vector<double> > &rows);
+  void print_summary (std::vector<std::string> &deck_names,
+                      std::vector<std::vector<double> > &rows,
+                      bool is_ensemble,
+                      ConditionalOStream &pcout);
+  // name with "-case<i>" inserted, e.g. "conv-case3.csv" for "conv.csv"
+  std::string get_case_file_name (const std::string &name, unsigned int i);
+  // everything a case may not change if it is to reuse the previous model
+  std::string get_structure_signature (ParameterHandler &prm);
+
   unsigned int dim;
+  unsigned int n_group;
   std::string transport_model_name;
   std::map<std::string, unsigned int> method_index;
+  std::map<std::string, double> run_summary;
+
+  std_cxx11::shared_ptr<TransportBase<2> > tb_2d;
+  std_cxx11::shared_ptr<TransportBase<3> > tb_3d;
 };
 
 #endif //__MODEL_MANAGER__H__
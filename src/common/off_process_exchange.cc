@@ -0,0 +1,256 @@
+#include <deal.II/base/utilities.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "off_process_exchange.h"
+
+OffProcessExchange::OffProcessExchange
+(MPI_Comm &mpi_communicator,
+ const IndexSet &locally_owned_dofs,
+ unsigned int n_objects)
+:
+n_objects(n_objects),
+n_procs(Utilities::MPI::n_mpi_processes (mpi_communicator)),
+this_proc(Utilities::MPI::this_mpi_process (mpi_communicator)),
+have_plan(false),
+send_rows(n_procs),
+send_cols(n_procs),
+send_values(n_objects, std::vector<std::vector<double> > (n_procs)),
+recv_rows(n_procs),
+recv_cols(n_procs),
+mpi_communicator(mpi_communicator)
+{
+  // first owned row and number of owned rows of every process
+  unsigned long long range[2] =
+  {
+    locally_owned_dofs.n_elements ()>0 ? locally_owned_dofs.nth_index_in_set (0) : 0,
+    locally_owned_dofs.n_elements ()
+  };
+  std::vector<unsigned long long> ranges (2 * n_procs);
+  MPI_Allgather (range, 2, MPI_UNSIGNED_LONG_LONG,
+                 &ranges[0], 2, MPI_UNSIGNED_LONG_LONG, mpi_communicator);
+  row_offsets.resize (n_procs + 1, 0);
+  bool is_ordered = true;
+  for (unsigned int p=0; p<n_procs; ++p)
+  {
+    is_ordered = is_ordered && (ranges[2*p+1]==0 || ranges[2*p]==row_offsets[p]);
+    row_offsets[p+1] = row_offsets[p] + ranges[2*p+1];
+  }
+  AssertThrow (Utilities::MPI::min (locally_owned_dofs.is_contiguous () ? 1 : 0,
+                                    mpi_communicator)==1 && is_ordered,
+               ExcMessage ("owned rows have to be contiguous and in process order"));
+}
+
+OffProcessExchange::~OffProcessExchange ()
+{
+  int is_finalized;
+  MPI_Finalized (&is_finalized);
+  if (have_plan && !is_finalized)
+    MPI_Type_free (&value_block);
+}
+
+unsigned int OffProcessExchange::get_owner (types::global_dof_index row)
+{
+  return (std::upper_bound (row_offsets.begin (), row_offsets.end (), row) -
+          row_offsets.begin () - 1);
+}
+
+void OffProcessExchange::buffer (unsigned int k, unsigned int owner,
+                                 types::global_dof_index row,
+                                 types::global_dof_index col,
+                                 double value,
+                                 bool with_col)
+{
+  if (k==0 && !have_plan)
+  {
+    send_rows[owner].push_back (row);
+    if (with_col)
+      send_cols[owner].push_back (col);
+  }
+  send_values[k][owner].push_back (value);
+}
+
+void OffProcessExchange::add (unsigned int k,
+                              const std::vector<types::global_dof_index> &rows,
+                              const std::vector<types::global_dof_index> &cols,
+                              const FullMatrix<double> &values,
+                              PETScWrappers::MPI::SparseMatrix &matrix)
+{
+  for (unsigned int i=0; i<rows.size(); ++i)
+  {
+    unsigned int owner = get_owner (rows[i]);
+    if (owner==this_proc)
+      matrix.add (rows[i], cols.size (), &cols[0], &values(i,0));
+    else
+      for (unsigned int j=0; j<cols.size(); ++j)
+        buffer (k, owner, rows[i], cols[j], values(i,j), true);
+  }
+}
+
+void OffProcessExchange::add (unsigned int k,
+                              const std::vector<types::global_dof_index> &rows,
+                              const Vector<double> &values,
+                              PETScWrappers::MPI::Vector &vector)
+{
+  for (unsigned int i=0; i<rows.size(); ++i)
+  {
+    unsigned int owner = get_owner (rows[i]);
+    if (owner==this_proc)
+      vector.add (1, &rows[i], &values(i));
+    else
+      buffer (k, owner, rows[i], 0, values(i), false);
+  }
+}
+
+bool OffProcessExchange::get_counts (const std::vector<unsigned long long> &n_entries,
+                                     std::vector<int> &counts,
+                                     std::vector<int> &displs)
+{
+  counts.assign (n_procs, 0);
+  displs.assign (n_procs, 0);
+  const unsigned long long max_count = std::numeric_limits<int>::max ();
+  unsigned long long total = 0;
+  for (unsigned int p=0; p<n_procs; ++p)
+  {
+    if (total + n_entries[p]>max_count)
+      return false;
+    counts[p] = n_entries[p];
+    displs[p] = total;
+    total += n_entries[p];
+  }
+  return true;
+}
+
+void OffProcessExchange::setup_plan (bool with_cols)
+{
+  std::vector<unsigned long long> n_send (n_procs), n_recv (n_procs);
+  for (unsigned int p=0; p<n_procs; ++p)
+    n_send[p] = send_rows[p].size ();
+  MPI_Alltoall (&n_send[0], 1, MPI_UNSIGNED_LONG_LONG,
+                &n_recv[0], 1, MPI_UNSIGNED_LONG_LONG, mpi_communicator);
+  // every process has to know if one of them cannot exchange, or the others
+  // would wait in MPI_Alltoallv
+  bool fits = get_counts (n_send, send_counts, send_displs);
+  fits = get_counts (n_recv, recv_counts, recv_displs) && fits;
+  AssertThrow (Utilities::MPI::min (fits ? 1 : 0, mpi_communicator)==1,
+               ExcMessage ("too many off-process entries for one MPI_Alltoallv"));
+  const std::size_t n_send_total = send_displs[n_procs-1] + send_counts[n_procs-1];
+  const std::size_t n_recv_total = recv_displs[n_procs-1] + recv_counts[n_procs-1];
+
+  // indices travel as unsigned long long whatever the width of
+  // types::global_dof_index
+  for (unsigned int pass=0; pass<(with_cols ? 2 : 1); ++pass)
+  {
+    std::vector<std::vector<types::global_dof_index> > &send = (pass==0 ? send_rows : send_cols);
+    std::vector<std::vector<types::global_dof_index> > &recv = (pass==0 ? recv_rows : recv_cols);
+    std::vector<unsigned long long> send_buffer (std::max (n_send_total, (std::size_t)1));
+    std::vector<unsigned long long> recv_buffer (std::max (n_recv_total, (std::size_t)1));
+    for (unsigned int p=0; p<n_procs; ++p)
+      std::copy (send[p].begin (), send[p].end (), send_buffer.begin () + send_displs[p]);
+    MPI_Alltoallv (&send_buffer[0], &send_counts[0], &send_displs[0], MPI_UNSIGNED_LONG_LONG,
+                   &recv_buffer[0], &recv_counts[0], &recv_displs[0], MPI_UNSIGNED_LONG_LONG,
+                   mpi_communicator);
+    for (unsigned int p=0; p<n_procs; ++p)
+      recv[p].assign (recv_buffer.begin () + recv_displs[p],
+                      recv_buffer.begin () + recv_displs[p] + recv_counts[p]);
+  }
+  // values travel as blocks of one entry of every object, so the counts of
+  // the pattern stay valid whatever the number of objects
+  MPI_Type_contiguous (n_objects, MPI_DOUBLE, &value_block);
+  MPI_Type_commit (&value_block);
+  have_plan = true;
+}
+
+std::vector<double> OffProcessExchange::exchange_values ()
+{
+  const std::size_t n_send_total = send_displs[n_procs-1] + send_counts[n_procs-1];
+  const std::size_t n_recv_total = recv_displs[n_procs-1] + recv_counts[n_procs-1];
+  std::vector<double> send_buffer (std::max (n_objects * n_send_total, (std::size_t)1));
+  std::vector<double> recv_buffer (std::max (n_objects * n_recv_total, (std::size_t)1));
+  for (unsigned int p=0; p<n_procs; ++p)
+    for (unsigned int k=0; k<n_objects; ++k)
+    {
+      AssertThrow (send_values[k][p].size()==send_rows[p].size(),
+                   ExcMessage ("every object has to be filled like the first one"));
+      std::copy (send_values[k][p].begin (), send_values[k][p].end (),
+                 send_buffer.begin () + n_objects * (std::size_t)send_displs[p] +
+                 k * send_rows[p].size ());
+      send_values[k][p].clear ();
+    }
+  MPI_Alltoallv (&send_buffer[0], &send_counts[0], &send_displs[0], value_block,
+                 &recv_buffer[0], &recv_counts[0], &recv_displs[0], value_block,
+                 mpi_communicator);
+  return recv_buffer;
+}
+
+void OffProcessExchange::exchange (std::vector<PETScWrappers::MPI::SparseMatrix*> &matrices)
+{
+  AssertThrow (matrices.size()==n_objects,
+               ExcMessage ("exchange needs every object of the family"));
+  if (!have_plan)
+    setup_plan (true);
+  std::vector<double> values = exchange_values ();
+  std::size_t pos = 0;
+  for (unsigned int p=0; p<n_procs; ++p)
+    for (unsigned int k=0; k<n_objects; ++k)
+    {
+      // entries come in runs of one row, add them row by row
+      unsigned int start = 0;
+      while (start<recv_rows[p].size())
+      {
+        unsigned int end = start + 1;
+        while (end<recv_rows[p].size() && recv_rows[p][end]==recv_rows[p][start])
+          ++end;
+        matrices[k]->add (recv_rows[p][start], end - start,
+                          &recv_cols[p][start], &values[pos + start], false);
+        start = end;
+      }
+      pos += recv_rows[p].size ();
+    }
+  // nothing is stashed any more, so the compress stays local; other users
+  // of the matrices get the stash back afterwards
+  for (unsigned int k=0; k<n_objects; ++k)
+  {
+    MatSetOption (static_cast<Mat>(*matrices[k]), MAT_NO_OFF_PROC_ENTRIES, PETSC_TRUE);
+    matrices[k]->compress (VectorOperation::add);
+    MatSetOption (static_cast<Mat>(*matrices[k]), MAT_NO_OFF_PROC_ENTRIES, PETSC_FALSE);
+  }
+}
+
+void OffProcessExchange::exchange (std::vector<PETScWrappers::MPI::Vector*> &vectors)
+{
+  AssertThrow (vectors.size()==n_objects,
+               ExcMessage ("exchange needs every object of the family"));
+  if (!have_plan)
+    setup_plan (false);
+  std::vector<double> values = exchange_values ();
+  std::size_t pos = 0;
+  for (unsigned int p=0; p<n_procs; ++p)
+    for (unsigned int k=0; k<n_objects; ++k)
+    {
+      if (recv_rows[p].size()>0)
+        vectors[k]->add (recv_rows[p].size (), &recv_rows[p][0], &values[pos]);
+      pos += recv_rows[p].size ();
+    }
+  for (unsigned int k=0; k<n_objects; ++k)
+  {
+    // entries stashed by someone else would be dropped by the compress
+    PetscInt n_stashed, n_reallocs, n_block_stashed, n_block_reallocs;
+    VecStashGetInfo (static_cast<Vec>(*vectors[k]), &n_stashed, &n_reallocs,
+                     &n_block_stashed, &n_block_reallocs);
+    AssertThrow (n_stashed==0 && n_block_stashed==0,
+                 ExcMessage ("off-process entries were added outside the exchange"));
+    VecSetOption (static_cast<Vec>(*vectors[k]), VEC_IGNORE_OFF_PROC_ENTRIES, PETSC_TRUE);
+    vectors[k]->compress (VectorOperation::add);
+    VecSetOption (static_cast<Vec>(*vectors[k]), VEC_IGNORE_OFF_PROC_ENTRIES, PETSC_FALSE);
+  }
+}
+
+double OffProcessExchange::get_send_bytes ()
+{
+  double n_entries = 0.0;
+  for (unsigned int p=0; p<n_procs; ++p)
+    n_entries += send_rows[p].size ();
+  return n_entries * n_objects * sizeof (double);
+}
@@ -0,0 +1,98 @@
+#ifndef __off_process_exchange_h__
+#define __off_process_exchange_h__
+
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/petsc_parallel_sparse_matrix.h>
+#include <deal.II/lac/petsc_parallel_vector.h>
+
+#include <vector>
+
+using namespace dealii;
+
+// Batched replacement for the PETSc stash of a family of matrices or vectors
+// that are filled by the same loop over cells, e.g. the HO component
+// matrices. Entries of rows owned by this process go straight into the
+// object; entries of other rows are buffered per object. exchange () ships
+// the buffers of all objects in one all-to-all and compresses the objects
+// locally.
+//
+// The (row, column) pattern of the off-process entries is recorded while
+// object 0 is filled and sent once; afterwards only values travel. Every
+// object therefore has to be filled by the same sequence of add calls.
+//
+// The final compress tells PETSc that nothing is stashed, and the option is
+// cleared again afterwards. Between two exchanges, the objects must not get
+// off-process entries any other way, since those would be dropped.
+class OffProcessExchange
+{
+public:
+  // the rows owned by every process have to be contiguous and follow those
+  // of the process before it, as with the default DoF numbering
+  OffProcessExchange (MPI_Comm &mpi_communicator,
+                      const IndexSet &locally_owned_dofs,
+                      unsigned int n_objects);
+  ~OffProcessExchange ();
+
+  void add (unsigned int k,
+            const std::vector<types::global_dof_index> &rows,
+            const std::vector<types::global_dof_index> &cols,
+            const FullMatrix<double> &values,
+            PETScWrappers::MPI::SparseMatrix &matrix);
+  void add (unsigned int k,
+            const std::vector<types::global_dof_index> &rows,
+            const Vector<double> &values,
+            PETScWrappers::MPI::Vector &vector);
+
+  // collective
+  void exchange (std::vector<PETScWrappers::MPI::SparseMatrix*> &matrices);
+  void exchange (std::vector<PETScWrappers::MPI::Vector*> &vectors);
+
+  // bytes this process sends in one exchange of values
+  double get_send_bytes ();
+
+private:
+  unsigned int get_owner (types::global_dof_index row);
+  void buffer (unsigned int k, unsigned int owner,
+               types::global_dof_index row,
+               types::global_dof_index col,
+               double value,
+               bool with_col);
+  // exchanges the recorded pattern on the first call
+  void setup_plan (bool with_cols);
+  // sends the buffered values, returns the received ones ordered by source
+  // process, then object, then entry
+  std::vector<double> exchange_values ();
+  // counts and displacements of MPI_Alltoallv from entries per process,
+  // false if they do not fit into int
+  bool get_counts (const std::vector<unsigned long long> &n_entries,
+                   std::vector<int> &counts,
+                   std::vector<int> &displs);
+
+  const unsigned int n_objects;
+  const unsigned int n_procs;
+  const unsigned int this_proc;
+  // first row owned by every process, plus the total at the end
+  std::vector<types::global_dof_index> row_offsets;
+
+  bool have_plan;
+  // per destination process
+  std::vector<std::vector<types::global_dof_index> > send_rows;
+  std::vector<std::vector<types::global_dof_index> > send_cols;
+  // per object and destination process
+  std::vector<std::vector<std::vector<double> > > send_values;
+  // per source process
+  std::vector<std::vector<types::global_dof_index> > recv_rows;
+  std::vector<std::vector<types::global_dof_index> > recv_cols;
+  // entries per process of the pattern
+  std::vector<int> send_counts, send_displs;
+  std::vector<int> recv_counts, recv_displs;
+  // one value of every object
+  MPI_Datatype value_block;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__off_process_exchange_h__
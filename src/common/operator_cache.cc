@@ -0,0 +1,183 @@
+#include <deal.II/base/utilities.h>
+
+#include <petscmat.h>
+#include <petscviewer.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+#include "operator_cache.h"
+
+OperatorCache::OperatorCache (ParameterHandler &prm, MPI_Comm &mpi_communicator)
+:
+directory(prm.get("operator cache directory")),
+hash(14695981039346656037ULL),
+mpi_communicator(mpi_communicator)
+{
+  if (!is_enabled ())
+    return;
+  // bump the version whenever the assembly changes what it produces
+  hash_string ("xtrans operator cache v2");
+
+  // every entry of the deck counts except those that only steer solvers,
+  // output and diagnostics: a stale entry is worse than a reassembly
+  const char *ignored_entries[] =
+  {
+    "HO linear solver name", "HO preconditioner name", "HO ssor factor",
+    "HO auto expected solves", "HO auto max direct DoFs",
+    "HO auto min DoFs per process", "HO solver autotune", "HO autotune file name",
+    "NDA linear solver name", "NDA preconditioner name", "NDA ssor factor",
+    "do print angular quadrature info", "do print memory report",
+    "do hardware counters", "log level", "output file name base",
+    "linear solver telemetry file name", "convergence history file name",
+    "communication ledger file name", "operator cache directory",
+    "HO preconditioner refresh threshold", "do critical search",
+    "critical search material IDs", "critical search initial scalings",
+    "critical search tolerance", "critical search max trials",
+    "reduced order model", "ROM training cases", "ROM error tolerance",
+    "ROM POD tolerance"
+  };
+  std::set<std::string> ignored (ignored_entries,
+                                 ignored_entries + sizeof (ignored_entries) / sizeof (ignored_entries[0]));
+  std::ostringstream deck;
+  prm.print_parameters (deck, ParameterHandler::Text);
+  std::istringstream lines (deck.str ());
+  std::string line;
+  while (std::getline (lines, line))
+  {
+    boost::algorithm::trim (line);
+    if (line.size()==0 || line[0]=='#')
+      continue;
+    if (line.find ("set ")==0)
+    {
+      std::size_t eq = line.find ('=');
+      std::string name = line.substr (4, eq - 4);
+      boost::algorithm::trim (name);
+      if (ignored.count (name))
+        continue;
+    }
+    hash_string (line);
+  }
+
+  // files named in the deck may change without the deck changing
+  if (!prm.get_bool ("is mesh generated by deal.II"))
+    hash_file (prm.get ("mesh file name"));
+  prm.enter_subsection ("material ID map");
+  hash_file (prm.get ("material id file name"));
+  prm.leave_subsection ();
+
+  const unsigned int n_procs = Utilities::MPI::n_mpi_processes (mpi_communicator);
+  hash_string (Utilities::int_to_string (n_procs));
+  std::ostringstream os;
+  os << std::hex << std::setw(16) << std::setfill('0') << hash << "-np" << n_procs;
+  key = os.str ();
+}
+
+OperatorCache::~OperatorCache ()
+{
+}
+
+bool OperatorCache::is_enabled ()
+{
+  return directory!="";
+}
+
+void OperatorCache::disable ()
+{
+  directory = "";
+}
+
+std::string OperatorCache::get_key ()
+{
+  return key;
+}
+
+void OperatorCache::hash_string (const std::string &str)
+{
+  for (unsigned int i=0; i<str.size(); ++i)
+  {
+    hash ^= static_cast<unsigned char>(str[i]);
+    hash *= 1099511628211ULL;
+  }
+  // separator, so that "ab"+"c" and "a"+"bc" differ
+  hash ^= 0xff;
+  hash *= 1099511628211ULL;
+}
+
+void OperatorCache::hash_file (std::string filename)
+{
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  std::ostringstream content;
+  content << in.rdbuf ();
+  hash_string (filename + ":" + content.str ());
+}
+
+bool OperatorCache::load (std::vector<PETScWrappers::MPI::SparseMatrix*> &matrices)
+{
+  if (!is_enabled ())
+    return false;
+  std::string filename = directory + "/" + key + ".petsc";
+  // every process has to agree, or the collective open would hang
+  bool exists = std::ifstream (filename.c_str ()).good ();
+  if (Utilities::MPI::min (exists ? 1 : 0, mpi_communicator)==0)
+    return false;
+
+  PetscViewer viewer;
+  PetscErrorCode ierr = PetscViewerBinaryOpen (mpi_communicator, filename.c_str (),
+                                               FILE_MODE_READ, &viewer);
+  AssertThrow (ierr==0, ExcMessage ("cannot open operator cache entry " + filename));
+  // MatLoad keeps the row partition the matrices were created with
+  for (unsigned int k=0; k<matrices.size(); ++k)
+  {
+    ierr = MatLoad (static_cast<Mat>(*matrices[k]), viewer);
+    AssertThrow (ierr==0, ExcMessage ("corrupt operator cache entry " + filename));
+  }
+  PetscViewerDestroy (&viewer);
+  return true;
+}
+
+void OperatorCache::store (std::vector<PETScWrappers::MPI::SparseMatrix*> &matrices)
+{
+  if (!is_enabled ())
+    return;
+  std::string filename = directory + "/" + key + ".petsc";
+  // another run or another sub-communicator of an ensemble got there first
+  bool exists = std::ifstream (filename.c_str ()).good ();
+  if (Utilities::MPI::min (exists ? 1 : 0, mpi_communicator)==1)
+    return;
+  // write under a temporary name so that a run killed halfway does not leave
+  // a truncated entry behind; the name belongs to this communicator alone,
+  // given by the process ID and world rank of its first process
+  int owner[2];
+  owner[0] = getpid ();
+  MPI_Comm_rank (MPI_COMM_WORLD, &owner[1]);
+  MPI_Bcast (owner, 2, MPI_INT, 0, mpi_communicator);
+  std::string tmp_filename = filename + ".tmp" +
+                             Utilities::int_to_string (owner[0]) + "-" +
+                             Utilities::int_to_string (owner[1]);
+  if (Utilities::MPI::this_mpi_process (mpi_communicator)==0)
+    mkdir (directory.c_str (), 0755);
+  MPI_Barrier (mpi_communicator);
+  PetscViewer viewer;
+  PetscErrorCode ierr = PetscViewerBinaryOpen (mpi_communicator, tmp_filename.c_str (),
+                                               FILE_MODE_WRITE, &viewer);
+  AssertThrow (ierr==0, ExcMessage ("cannot write operator cache entry " + tmp_filename));
+  for (unsigned int k=0; k<matrices.size(); ++k)
+    MatView (static_cast<Mat>(*matrices[k]), viewer);
+  PetscViewerDestroy (&viewer);
+  if (Utilities::MPI::this_mpi_process (mpi_communicator)==0)
+  {
+    std::rename (tmp_filename.c_str (), filename.c_str ());
+    // PETSc writes an .info file next to the binary one
+    std::rename ((tmp_filename + ".info").c_str (), (filename + ".info").c_str ());
+  }
+  MPI_Barrier (mpi_communicator);
+}
@@ -0,0 +1,48 @@
+#ifndef __operator_cache_h__
+#define __operator_cache_h__
+
+#include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/lac/petsc_parallel_sparse_matrix.h>
+
+#include <string>
+#include <vector>
+
+using namespace dealii;
+
+// On-disk cache of the assembled HO component matrices in PETSc's binary
+// format. Entries are keyed by a hash of every input that can change the
+// matrices (the deck minus solver and output settings, the mesh and material
+// id files) and the process count, since the row partition has to match.
+// Preconditioners and MUMPS factors cannot be written by PETSc and are
+// always rebuilt.
+class OperatorCache
+{
+public:
+  // an empty cache directory disables the cache
+  OperatorCache (ParameterHandler &prm, MPI_Comm &mpi_communicator);
+  ~OperatorCache ();
+
+  bool is_enabled ();
+  // once the matrices no longer follow the deck, e.g. in a critical search
+  void disable ();
+  std::string get_key ();
+  // collective: true if an entry for this key existed and every matrix was
+  // loaded from it
+  bool load (std::vector<PETScWrappers::MPI::SparseMatrix*> &matrices);
+  // collective: writes the matrices under this key unless an entry exists
+  void store (std::vector<PETScWrappers::MPI::SparseMatrix*> &matrices);
+
+private:
+  void hash_string (const std::string &str);
+  void hash_file (std::string filename);
+
+  std::string directory;
+  std::string key;
+  // FNV-1a state
+  unsigned long long hash;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__operator_cache_h__
@@ -1,4 +1,14 @@
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/utilities.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
 #include "preconditioner_solver.h"
+#include "memory_report.h"
 
 PreconditionerSolver::PreconditionerSolver (ParameterHandler &prm,
                                             unsigned int& n_total_ho_vars,
@@ -10,13 +20,45 @@ mpi_communicator(mpi_communicator),
 transport_model_name(prm.get("transport model")),
 ho_linear_solver_name(prm.get("HO linear solver name")),
 ho_preconditioner_name(prm.get("HO preconditioner name")),
-do_nda(prm.get_bool("do NDA"))
+do_nda(prm.get_bool("do NDA")),
+ho_preconditioner_bytes(0.0),
+ho_direct_bytes(0.0)
 {
   if (transport_model_name=="ep")
     have_reflective_bc = prm.get_bool ("have reflective BC");
   
-  if (ho_preconditioner_name=="bssor")
+  // every component has its own operator until told otherwise
+  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+    ho_operator_of.push_back (i);
+  n_unique_ho_operators = n_total_ho_vars;
+  if (ho_preconditioner_name=="bssor" || ho_preconditioner_name=="auto")
     ho_ssor_omega = prm.get_double ("HO ssor factor");
+  do_autotune = prm.get_bool ("HO solver autotune");
+  is_autotuned = false;
+  if (do_autotune ||
+      ho_linear_solver_name=="auto" || ho_preconditioner_name=="auto")
+  {
+    ho_expected_solves = prm.get_integer ("HO auto expected solves");
+    ho_max_direct_dofs = prm.get_integer ("HO auto max direct DoFs");
+    ho_min_dofs_per_proc = prm.get_integer ("HO auto min DoFs per process");
+  }
+  if (do_autotune)
+  {
+    AssertThrow (ho_linear_solver_name!="auto" && ho_preconditioner_name!="auto",
+                 ExcMessage("autotuning starts from a fixed solver and preconditioner"));
+    // a problem class: everything that changes which pair is fastest
+    std::ostringstream key;
+    key << prm.get ("problem dimension") << "d-"
+    << prm.get ("spatial discretization") << "-p" << prm.get ("finite element polynomial degree")
+    << "-s" << prm.get ("angular quadrature order") << "-g" << n_group
+    << "-r" << prm.get ("uniform refinements")
+    << "-" << (is_ho_symmetric () ? "sym" : "nonsym")
+    << "-np" << Utilities::MPI::n_mpi_processes (mpi_communicator);
+    autotune_key = key.str ();
+    autotune_filename = prm.get ("HO autotune file name");
+    if (autotune_filename!="")
+      load_autotuned_ho_solver ();
+  }
   
 	if (do_nda)
 	{
@@ -42,198 +84,585 @@ void PreconditionerSolver::initialize_ho_preconditioners
                ExcMessage("num of HO system matrices should be equal to total variable number"));
   AssertThrow (n_total_ho_vars==ho_rhses.size(),
                ExcMessage("num of HO system rhs should be equal to total variable number"));
+  ho_linear_iters = std::vector<unsigned int> (n_total_ho_vars, 0);
+  ho_solve_times = std::vector<double> (n_total_ho_vars, 0.0);
+  ho_final_residuals = std::vector<double> (n_total_ho_vars, 0.0);
+  ho_convergence_failures = std::vector<bool> (n_total_ho_vars, false);
+  // keep what was set up during assembly
+  if (ho_preconditioner_ready.size ()!=n_total_ho_vars)
+    prepare_ho_preconditioners ();
+  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+    if (!ho_preconditioner_ready[i] && ho_operator_of[i]==i)
+      setup_ho_preconditioner (i, *ho_syses[i]);
+  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+    if (ho_operator_of[i]!=i)
+      share_ho_preconditioner (i, ho_operator_of[i]);
+  // later calls, e.g. after autotuning, set up everything again
+  ho_preconditioner_ready.clear ();
+  // initialize HO solver controls
+  ho_cn.resize (n_total_ho_vars);
+  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+    ho_cn[i] = std_cxx11::shared_ptr<SolverControl>
+    (new SolverControl(ho_rhses[i]->size(), 1.0e-12*ho_rhses[i]->l1_norm()));
+}
+
+void PreconditionerSolver::prepare_ho_preconditioners ()
+{
+  AssertThrow (ho_linear_solver_name!="auto" && ho_preconditioner_name!="auto",
+               ExcMessage("select_ho_solver has to run before preconditioners are initialized"));
+  resize_ho_preconditioners ();
+  ho_preconditioner_ready = std::vector<bool> (n_total_ho_vars, false);
+  ho_preconditioner_bytes = 0.0;
+}
+
+void PreconditionerSolver::setup_ho_preconditioner
+(unsigned int i, PETScWrappers::MPI::SparseMatrix &ho_sys)
+{
+  double rss_before = MemoryReport::get_current_rss ();
+  if (ho_linear_solver_name!="direct")
+    initialize_ho_preconditioner (i, ho_sys);
+  ho_preconditioner_bytes += MemoryReport::get_current_rss () - rss_before;
+  ho_preconditioner_ready[i] = true;
+}
+
+void PreconditionerSolver::set_ho_operator_map
+(const std::vector<unsigned int> &ho_operator_of)
+{
+  AssertThrow (ho_operator_of.size()==n_total_ho_vars,
+               ExcMessage("need the operator of every component"));
+  this->ho_operator_of = ho_operator_of;
+  n_unique_ho_operators = 0;
+  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+    if (ho_operator_of[i]==i)
+      ++n_unique_ho_operators;
+}
+
+void PreconditionerSolver::keep_ho_preconditioners (const std::vector<bool> &is_kept)
+{
+  AssertThrow (is_kept.size()==n_total_ho_vars,
+               ExcMessage("need a flag for every component"));
+  if (ho_linear_solver_name=="direct")
+    return;
+  ho_preconditioner_ready = is_kept;
+  // kept preconditioners hold the matrix that was just changed in place, so
+  // PETSc would set them up again in the next solve unless told otherwise
+  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+    if (ho_operator_of[i]==i)
+      set_ho_preconditioner_reuse (i, is_kept[i]);
+}
+
+void PreconditionerSolver::set_ho_preconditioner_reuse (unsigned int i, bool is_reused)
+{
+  const PETScWrappers::PreconditionerBase *pre = NULL;
+  if (ho_preconditioner_name=="amg")
+    pre = pre_ho_amg[i].get ();
+  else if (ho_preconditioner_name=="bjacobi")
+    pre = pre_ho_bjacobi[i].get ();
+  else if (ho_preconditioner_name=="jacobi")
+    pre = pre_ho_jacobi[i].get ();
+  else if (ho_preconditioner_name=="bssor")
+    pre = pre_ho_eisenstat[i].get ();
+  else if (ho_preconditioner_name=="parasails")
+    pre = pre_ho_parasails[i].get ();
+  if (pre!=NULL)
+    PCSetReusePreconditioner (pre->get_pc (), is_reused ? PETSC_TRUE : PETSC_FALSE);
+}
+
+void PreconditionerSolver::share_ho_preconditioner (unsigned int i, unsigned int op)
+{
+  if (ho_linear_solver_name=="direct")
+    return;
+  if (ho_preconditioner_name=="amg")
+    pre_ho_amg[i] = pre_ho_amg[op];
+  else if (ho_preconditioner_name=="bjacobi")
+    pre_ho_bjacobi[i] = pre_ho_bjacobi[op];
+  else if (ho_preconditioner_name=="jacobi")
+    pre_ho_jacobi[i] = pre_ho_jacobi[op];
+  else if (ho_preconditioner_name=="bssor")
+    pre_ho_eisenstat[i] = pre_ho_eisenstat[op];
+  else if (ho_preconditioner_name=="parasails")
+    pre_ho_parasails[i] = pre_ho_parasails[op];
+  ho_preconditioner_ready[i] = true;
+}
+
+void PreconditionerSolver::resize_ho_preconditioners ()
+{
   if (ho_linear_solver_name!="direct")
   {
-    ho_linear_iters.resize (n_total_ho_vars);
     if (ho_preconditioner_name=="amg")
-    {
       pre_ho_amg.resize (n_total_ho_vars);
-      for (unsigned int i=0; i<n_total_ho_vars; ++i)
-      {
-        pre_ho_amg[i] = (std_cxx11::shared_ptr<PETScWrappers::PreconditionBoomerAMG>
-                         (new PETScWrappers::PreconditionBoomerAMG));
-        PETScWrappers::PreconditionBoomerAMG::AdditionalData data;
-        if (transport_model_name=="fo" ||
-            (transport_model_name=="ep" && have_reflective_bc))
-          data.symmetric_operator = false;
-        else
-          data.symmetric_operator = true;
-        pre_ho_amg[i]->initialize(*(ho_syses)[i], data);
-      }
-    }
     else if (ho_preconditioner_name=="bjacobi")
-    {
       pre_ho_bjacobi.resize (n_total_ho_vars);
-      for (unsigned int i=0; i<n_total_ho_vars; ++i)
-      {
-        pre_ho_bjacobi[i] = std_cxx11::shared_ptr<PETScWrappers::PreconditionBlockJacobi>
-        (new PETScWrappers::PreconditionBlockJacobi);
-        pre_ho_bjacobi[i]->initialize(*(ho_syses)[i]);
-      }
-    }
     else if (ho_preconditioner_name=="jacobi")
-    {
       pre_ho_jacobi.resize (n_total_ho_vars);
-      for (unsigned int i=0; i<n_total_ho_vars; ++i)
-      {
-        pre_ho_jacobi[i] = std_cxx11::shared_ptr<PETScWrappers::PreconditionJacobi>
-        (new PETScWrappers::PreconditionJacobi);
-        pre_ho_jacobi[i]->initialize(*(ho_syses)[i]);
-      }
-    }
     else if (ho_preconditioner_name=="bssor")
-    {
       pre_ho_eisenstat.resize (n_total_ho_vars);
-      for (unsigned int i=0; i<n_total_ho_vars; ++i)
-      {
-        pre_ho_eisenstat[i] = std_cxx11::shared_ptr<PETScWrappers::PreconditionEisenstat>
-        (new PETScWrappers::PreconditionEisenstat);
-        PETScWrappers::PreconditionEisenstat::AdditionalData data(ho_ssor_omega);
-        pre_ho_eisenstat[i]->initialize(*(ho_syses)[i], data);
-      }
-    }
     else if (ho_preconditioner_name=="parasails")
-    {
       pre_ho_parasails.resize (n_total_ho_vars);
-      for (unsigned int i=0; i<n_total_ho_vars; ++i)
-      {
-        pre_ho_parasails[i] = (std_cxx11::shared_ptr<PETScWrappers::PreconditionParaSails>
-                               (new PETScWrappers::PreconditionParaSails));
-        if (transport_model_name=="fo" ||
-            (transport_model_name=="ep" && have_reflective_bc))
-        {
-          PETScWrappers::PreconditionParaSails::AdditionalData data (2);
-          pre_ho_parasails[i]->initialize(*(ho_syses)[i], data);
-        }
-        else
-        {
-          PETScWrappers::PreconditionParaSails::AdditionalData data (1);
-          pre_ho_parasails[i]->initialize(*(ho_syses)[i], data);
-        }
-      }
-    }
-  }// not direct solver
+  }
   else
   {
     ho_direct.resize (n_total_ho_vars);
     ho_direct_init = std::vector<bool> (n_total_ho_vars, false);
   }
-  // initialize HO solver controls
+}
+
+void PreconditionerSolver::initialize_ho_preconditioner
+(unsigned int i, PETScWrappers::MPI::SparseMatrix &ho_sys)
+{
+  if (ho_preconditioner_name=="amg")
+  {
+    pre_ho_amg[i] = (std_cxx11::shared_ptr<PETScWrappers::PreconditionBoomerAMG>
+                     (new PETScWrappers::PreconditionBoomerAMG));
+    PETScWrappers::PreconditionBoomerAMG::AdditionalData data;
+    data.symmetric_operator = is_ho_symmetric ();
+    pre_ho_amg[i]->initialize(ho_sys, data);
+  }
+  else if (ho_preconditioner_name=="bjacobi")
+  {
+    pre_ho_bjacobi[i] = std_cxx11::shared_ptr<PETScWrappers::PreconditionBlockJacobi>
+    (new PETScWrappers::PreconditionBlockJacobi);
+    pre_ho_bjacobi[i]->initialize(ho_sys);
+  }
+  else if (ho_preconditioner_name=="jacobi")
+  {
+    pre_ho_jacobi[i] = std_cxx11::shared_ptr<PETScWrappers::PreconditionJacobi>
+    (new PETScWrappers::PreconditionJacobi);
+    pre_ho_jacobi[i]->initialize(ho_sys);
+  }
+  else if (ho_preconditioner_name=="bssor")
+  {
+    pre_ho_eisenstat[i] = std_cxx11::shared_ptr<PETScWrappers::PreconditionEisenstat>
+    (new PETScWrappers::PreconditionEisenstat);
+    PETScWrappers::PreconditionEisenstat::AdditionalData data(ho_ssor_omega);
+    pre_ho_eisenstat[i]->initialize(ho_sys, data);
+  }
+  else if (ho_preconditioner_name=="parasails")
+  {
+    pre_ho_parasails[i] = (std_cxx11::shared_ptr<PETScWrappers::PreconditionParaSails>
+                           (new PETScWrappers::PreconditionParaSails));
+    // symmetric pattern for symmetric operators, nonsymmetric otherwise
+    PETScWrappers::PreconditionParaSails::AdditionalData data
+    (is_ho_symmetric () ? 1 : 2);
+    pre_ho_parasails[i]->initialize(ho_sys, data);
+  }
+}
+
+bool PreconditionerSolver::is_ho_symmetric ()
+{
+  return !(transport_model_name=="fo" ||
+           (transport_model_name=="ep" && have_reflective_bc));
+}
+
+void PreconditionerSolver::select_ho_solver
+(std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+ std::vector<PETScWrappers::MPI::Vector*> &ho_rhses,
+ ConditionalOStream &pcout)
+{
+  if (ho_linear_solver_name!="auto" && ho_preconditioner_name!="auto")
+    return;
+  AssertThrow (n_total_ho_vars==ho_syses.size(),
+               ExcMessage("num of HO system matrices should be equal to total variable number"));
+  const unsigned int n_procs = Utilities::MPI::n_mpi_processes (mpi_communicator);
+  const double dofs_per_proc = 1.0 * ho_rhses[0]->size () / n_procs;
+  // the code only decomposes space: every process owns a part of the mesh for
+  // all directions and groups, so the split is fixed and only reported here
+  pcout << "Parallel decomposition: space over " << n_procs << " processes ("
+  << dofs_per_proc << " DoFs per component and process), "
+  << MultithreadInfo::n_threads () << " threads per process; directions and "
+  << "groups are not distributed" << std::endl;
+  if (n_procs>1 && dofs_per_proc<ho_min_dofs_per_proc)
+    pcout << "  fewer than " << ho_min_dofs_per_proc << " DoFs per process, "
+    << "fewer processes would likely be faster" << std::endl;
+
+  // candidate pairs, restricted by whichever of the two names is fixed
+  const std::string krylov = is_ho_symmetric () ? "cg" : "gmres";
+  const std::string names[] = {"amg", "parasails", "bssor", "jacobi"};
+  std::vector<std::pair<std::string, std::string> > candidates;
+  for (unsigned int c=0; c<4; ++c)
+    if (ho_linear_solver_name!="direct" &&
+        (ho_preconditioner_name=="auto" || ho_preconditioner_name==names[c]))
+      candidates.push_back (std::make_pair
+                            (ho_linear_solver_name=="auto" ? krylov : ho_linear_solver_name,
+                             names[c]));
+  if ((ho_linear_solver_name=="auto" || ho_linear_solver_name=="direct") &&
+      ho_rhses[0]->size ()<=ho_max_direct_dofs)
+    candidates.push_back (std::make_pair ("direct", ""));
+  AssertThrow (candidates.size()>0,
+               ExcMessage("no HO solver candidate left for this problem size"));
+
+  // trial solves on the first and last component, i.e. two directions far
+  // apart, from a zero guess with a unit right hand side
+  std::vector<unsigned int> samples (1, 0);
+  if (n_total_ho_vars>1)
+    samples.push_back (n_total_ho_vars - 1);
+  std::vector<std_cxx11::shared_ptr<PETScWrappers::MPI::Vector> > unit_rhses, zero_psis;
+  std::vector<PETScWrappers::MPI::Vector*> trial_rhses, trial_psis;
+  for (unsigned int s=0; s<samples.size(); ++s)
+  {
+    unit_rhses.push_back (std_cxx11::shared_ptr<PETScWrappers::MPI::Vector>
+                          (new PETScWrappers::MPI::Vector (*ho_rhses[samples[s]])));
+    *unit_rhses[s] = 1.0;
+    zero_psis.push_back (std_cxx11::shared_ptr<PETScWrappers::MPI::Vector>
+                         (new PETScWrappers::MPI::Vector (*ho_rhses[samples[s]])));
+    *zero_psis[s] = 0.0;
+    trial_rhses.push_back (unit_rhses[s].get ());
+    trial_psis.push_back (zero_psis[s].get ());
+  }
+  unsigned int best = time_ho_candidates (candidates, samples, ho_syses,
+                                          trial_psis, trial_rhses, pcout);
+  ho_linear_solver_name = candidates[best].first;
+  ho_preconditioner_name = candidates[best].second;
+}
+
+void PreconditionerSolver::autotune_ho_solver
+(std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+ std::vector<PETScWrappers::MPI::Vector*> &ho_psis,
+ std::vector<PETScWrappers::MPI::Vector*> &ho_rhses,
+ ConditionalOStream &pcout)
+{
+  if (!do_autotune || is_autotuned)
+    return;
+  // every valid pair; CG needs a symmetric operator
+  const std::string solver_names[] = {"cg", "gmres", "bicgstab"};
+  const std::string names[] = {"amg", "parasails", "bjacobi", "jacobi", "bssor"};
+  std::vector<std::pair<std::string, std::string> > candidates;
+  for (unsigned int s=0; s<3; ++s)
+    if (solver_names[s]!="cg" || is_ho_symmetric ())
+      for (unsigned int c=0; c<5; ++c)
+        candidates.push_back (std::make_pair (solver_names[s], names[c]));
+  if (ho_rhses[0]->size ()<=ho_max_direct_dofs)
+    candidates.push_back (std::make_pair ("direct", ""));
+
+  // first, middle and last component: directions spread over the sphere and,
+  // in multigroup problems, the first and last groups
+  std::vector<unsigned int> samples (1, 0);
+  if (n_total_ho_vars>2)
+    samples.push_back (n_total_ho_vars / 2);
+  if (n_total_ho_vars>1)
+    samples.push_back (n_total_ho_vars - 1);
+  std::vector<PETScWrappers::MPI::Vector*> trial_psis, trial_rhses;
+  for (unsigned int s=0; s<samples.size(); ++s)
+  {
+    trial_psis.push_back (ho_psis[samples[s]]);
+    trial_rhses.push_back (ho_rhses[samples[s]]);
+  }
+  // the preconditioners of the configured pair go away with the trials
+  unsigned int best = time_ho_candidates (candidates, samples, ho_syses,
+                                          trial_psis, trial_rhses, pcout);
+  ho_linear_solver_name = candidates[best].first;
+  ho_preconditioner_name = candidates[best].second;
+  initialize_ho_preconditioners (ho_syses, ho_rhses);
+  is_autotuned = true;
+  if (autotune_filename!="" &&
+      Utilities::MPI::this_mpi_process (mpi_communicator)==0)
+  {
+    std::ofstream out (autotune_filename.c_str (), std::ios::app);
+    out << autotune_key << " " << ho_linear_solver_name << " "
+    << (ho_preconditioner_name=="" ? "none" : ho_preconditioner_name) << std::endl;
+  }
+}
+
+bool PreconditionerSolver::is_autotune_pending ()
+{
+  return do_autotune && !is_autotuned;
+}
+
+void PreconditionerSolver::load_autotuned_ho_solver ()
+{
+  // the latest record of this problem class wins
+  std::ifstream in (autotune_filename.c_str ());
+  std::string line;
+  while (std::getline (in, line))
+  {
+    std::istringstream record (line);
+    std::string key, solver_name, preconditioner_name;
+    if (record >> key >> solver_name >> preconditioner_name && key==autotune_key)
+    {
+      ho_linear_solver_name = solver_name;
+      ho_preconditioner_name = (preconditioner_name=="none" ? "" : preconditioner_name);
+      is_autotuned = true;
+    }
+  }
+}
+
+unsigned int PreconditionerSolver::time_ho_candidates
+(std::vector<std::pair<std::string, std::string> > &candidates,
+ std::vector<unsigned int> &samples,
+ std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+ std::vector<PETScWrappers::MPI::Vector*> &trial_psis,
+ std::vector<PETScWrappers::MPI::Vector*> &trial_rhses,
+ ConditionalOStream &pcout)
+{
   ho_cn.resize (n_total_ho_vars);
-  for (unsigned int i=0; i<n_total_ho_vars; ++i)
-    ho_cn[i] = std_cxx11::shared_ptr<SolverControl>
-    (new SolverControl(ho_rhses[i]->size(), 1.0e-12*ho_rhses[i]->l1_norm()));
+  std::vector<double> setup_times, solve_times, iters, predicted_times;
+  for (unsigned int c=0; c<candidates.size(); ++c)
+  {
+    ho_linear_solver_name = candidates[c].first;
+    ho_preconditioner_name = candidates[c].second;
+    resize_ho_preconditioners ();
+    double setup_time = 0.0, solve_time = 0.0, n_iters = 0.0;
+    bool converged = true;
+    for (unsigned int s=0; s<samples.size(); ++s)
+    {
+      const unsigned int k = samples[s];
+      // every candidate starts from the same guess
+      PETScWrappers::MPI::Vector psi (*trial_psis[s]);
+      ho_cn[k] = std_cxx11::shared_ptr<SolverControl>
+      (new SolverControl(trial_rhses[s]->size(), 1.0e-10*trial_rhses[s]->l1_norm()));
+      Timer timer;
+      timer.start ();
+      try
+      {
+        // MUMPS factorizes in its first solve, a second solve separates
+        // factorization from the solve itself
+        if (ho_linear_solver_name=="direct")
+          solve_ho_component (k, *ho_syses[k], psi, *trial_rhses[s]);
+        else
+          initialize_ho_preconditioner (k, *ho_syses[k]);
+        timer.stop ();
+        setup_time += timer.wall_time ();
+        psi = *trial_psis[s];
+        timer.restart ();
+        solve_ho_component (k, *ho_syses[k], psi, *trial_rhses[s]);
+        timer.stop ();
+        solve_time += timer.wall_time ();
+        if (ho_linear_solver_name=="direct")
+          setup_time -= timer.wall_time ();
+        else
+          n_iters += ho_cn[k]->last_step ();
+      }
+      catch (SolverControl::NoConvergence &exc)
+      {
+        converged = false;
+      }
+    }
+    // all processes have to pick the same pair, so decide on the slowest
+    setup_times.push_back (Utilities::MPI::max (setup_time / samples.size (),
+                                                mpi_communicator));
+    solve_times.push_back (Utilities::MPI::max (solve_time / samples.size (),
+                                                mpi_communicator));
+    iters.push_back (n_iters / samples.size ());
+    // only the unique operators are set up or factorized, every component
+    // is solved
+    predicted_times.push_back
+    (converged ?
+     (n_unique_ho_operators * std::max (setup_times[c], 0.0) +
+      n_total_ho_vars * ho_expected_solves * solve_times[c]) :
+     std::numeric_limits<double>::max ());
+    pre_ho_amg.clear ();
+    pre_ho_parasails.clear ();
+    pre_ho_bjacobi.clear ();
+    pre_ho_eisenstat.clear ();
+    pre_ho_jacobi.clear ();
+    ho_direct.clear ();
+  }
+  ho_direct_bytes = 0.0;
+
+  unsigned int best = std::min_element (predicted_times.begin (),
+                                        predicted_times.end ()) - predicted_times.begin ();
+  AssertThrow (predicted_times[best]<std::numeric_limits<double>::max (),
+               ExcMessage("no HO solver candidate converged in the trial solves"));
+
+  pcout << "HO solver selection (" << samples.size () << " trial component(s), "
+  << ho_expected_solves << " solves per component assumed, max time over processes)"
+  << std::endl;
+  pcout << std::setw(22) << std::left << "solver/preconditioner"
+  << std::setw(12) << std::right << "setup (s)"
+  << std::setw(12) << "solve (s)"
+  << std::setw(10) << "iters"
+  << std::setw(16) << "predicted (s)" << std::endl;
+  for (unsigned int c=0; c<candidates.size(); ++c)
+  {
+    pcout << std::setw(22) << std::left
+    << (candidates[c].second=="" ? candidates[c].first :
+        candidates[c].first + "/" + candidates[c].second)
+    << std::setw(12) << std::right << std::scientific << std::setprecision(2)
+    << setup_times[c] << std::setw(12) << solve_times[c]
+    << std::setw(10) << std::fixed << std::setprecision(0) << iters[c]
+    << std::setw(16) << std::scientific << std::setprecision(2);
+    if (predicted_times[c]<std::numeric_limits<double>::max ())
+      pcout << predicted_times[c] << std::endl;
+    else
+      pcout << "no conv." << std::endl;
+  }
+  pcout.get_stream().unsetf (std::ios_base::floatfield);
+  pcout << "Selected HO linear solver: " << candidates[best].first;
+  if (candidates[best].first!="direct")
+    pcout << ", preconditioner: " << candidates[best].second;
+  pcout << std::endl;
+  return best;
+}
+
+std::string PreconditionerSolver::get_ho_linear_solver_name ()
+{
+  return ho_linear_solver_name;
+}
+
+std::string PreconditionerSolver::get_ho_preconditioner_name ()
+{
+  return ho_preconditioner_name;
 }
 
 void PreconditionerSolver::ho_solve
 (std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
  std::vector<PETScWrappers::MPI::Vector*> &ho_psis,
  std::vector<PETScWrappers::MPI::Vector*> &ho_rhses)
+{
+  std::vector<unsigned int> components (n_total_ho_vars);
+  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+    components[i] = i;
+  ho_solve (ho_syses, ho_psis, ho_rhses, components);
+}
+
+void PreconditionerSolver::ho_solve
+(std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+ std::vector<PETScWrappers::MPI::Vector*> &ho_psis,
+ std::vector<PETScWrappers::MPI::Vector*> &ho_rhses,
+ const std::vector<unsigned int> &components)
 {
   AssertThrow (n_total_ho_vars==ho_syses.size(),
                ExcMessage("num of HO system matrices should be equal to total variable number"));
   AssertThrow (n_total_ho_vars==ho_rhses.size(),
                ExcMessage("num of HO system rhs should be equal to total variable number"));
-  for (unsigned int i=0; i<n_total_ho_vars; ++i)
+  for (unsigned int c=0; c<components.size(); ++c)
   {
-    if (ho_linear_solver_name=="cg")
+    unsigned int i = components[c];
+    Timer timer;
+    timer.start ();
+    ho_convergence_failures[i] = false;
+    try
     {
-      PETScWrappers::SolverCG
-      solver (*ho_cn[i], mpi_communicator);
-      if (ho_preconditioner_name=="amg")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_amg)[i]);
-      else if (ho_preconditioner_name=="jacobi")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_jacobi)[i]);
-      else if (ho_preconditioner_name=="bssor")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_eisenstat)[i]);
-      else if (ho_preconditioner_name=="parasails")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_parasails)[i]);
+      solve_ho_component (i, *ho_syses[i], *ho_psis[i], *ho_rhses[i]);
     }
-    else if (ho_linear_solver_name=="bicgstab")
+    catch (SolverControl::NoConvergence &exc)
     {
-      PETScWrappers::SolverBicgstab
-      solver (*ho_cn[i], mpi_communicator);
-      if (ho_preconditioner_name=="amg")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_amg)[i]);
-      else if (ho_preconditioner_name=="jacobi")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_jacobi)[i]);
-      else if (ho_preconditioner_name=="bssor")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_eisenstat)[i]);
-      else if (ho_preconditioner_name=="parasails")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_parasails)[i]);
+      ho_convergence_failures[i] = true;
     }
-    else if (ho_linear_solver_name=="gmres")
+    timer.stop ();
+    ho_solve_times[i] = timer.wall_time ();
+    // the ho_linear_iters are for reporting linear solver status
+    if (ho_linear_solver_name!="direct")
     {
-      PETScWrappers::SolverGMRES
-      solver (*ho_cn[i], mpi_communicator);
-      if (ho_preconditioner_name=="amg")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_amg)[i]);
-      else if (ho_preconditioner_name=="jacobi")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_jacobi)[i]);
-      else if (ho_preconditioner_name=="bssor")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_eisenstat)[i]);
-      else if (ho_preconditioner_name=="parasails")
-        solver.solve (*ho_syses[i],
-                      *ho_psis[i],
-                      *ho_rhses[i],
-                      *(pre_ho_parasails)[i]);
+      ho_linear_iters[i] = ho_cn[i]->last_step ();
+      ho_final_residuals[i] = ho_cn[i]->last_value ();
     }
-    else// if (linear_solver_name=="direct")
+    // the statistics of the failed solve are kept for the telemetry, the run
+    // still aborts
+    if (ho_convergence_failures[i])
+      throw SolverControl::NoConvergence (ho_cn[i]->last_step (),
+                                          ho_cn[i]->last_value ());
+  }
+}
+
+void PreconditionerSolver::solve_ho_component
+(unsigned int i,
+ PETScWrappers::MPI::SparseMatrix &ho_sys,
+ PETScWrappers::MPI::Vector &ho_psi,
+ PETScWrappers::MPI::Vector &ho_rhs)
+{
+  if (ho_linear_solver_name=="cg")
+  {
+    PETScWrappers::SolverCG
+    solver (*ho_cn[i], mpi_communicator);
+    if (ho_preconditioner_name=="amg")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_amg)[i]);
+    else if (ho_preconditioner_name=="jacobi")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_jacobi)[i]);
+    else if (ho_preconditioner_name=="bssor")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_eisenstat)[i]);
+    else if (ho_preconditioner_name=="parasails")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_parasails)[i]);
+    else if (ho_preconditioner_name=="bjacobi")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_bjacobi)[i]);
+  }
+  else if (ho_linear_solver_name=="bicgstab")
+  {
+    PETScWrappers::SolverBicgstab
+    solver (*ho_cn[i], mpi_communicator);
+    if (ho_preconditioner_name=="amg")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_amg)[i]);
+    else if (ho_preconditioner_name=="jacobi")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_jacobi)[i]);
+    else if (ho_preconditioner_name=="bssor")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_eisenstat)[i]);
+    else if (ho_preconditioner_name=="parasails")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_parasails)[i]);
+    else if (ho_preconditioner_name=="bjacobi")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_bjacobi)[i]);
+  }
+  else if (ho_linear_solver_name=="gmres")
+  {
+    PETScWrappers::SolverGMRES
+    solver (*ho_cn[i], mpi_communicator);
+    if (ho_preconditioner_name=="amg")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_amg)[i]);
+    else if (ho_preconditioner_name=="jacobi")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_jacobi)[i]);
+    else if (ho_preconditioner_name=="bssor")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_eisenstat)[i]);
+    else if (ho_preconditioner_name=="parasails")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_parasails)[i]);
+    else if (ho_preconditioner_name=="bjacobi")
+      solver.solve (ho_sys, ho_psi, ho_rhs, *(pre_ho_bjacobi)[i]);
+  }
+  else// if (linear_solver_name=="direct")
+  {
+    // factorization happens in the first solve, so that is where MUMPS
+    // memory is measured
+    bool first_solve = !ho_direct_init[i];
+    double rss_before = MemoryReport::get_current_rss ();
+    const unsigned int op = ho_operator_of[i];
+    if (!ho_direct_init[i] && op!=i && ho_direct_init[op])
     {
-      if (!ho_direct_init[i])
-      {
-        ho_direct[i] = std_cxx11::shared_ptr<PETScWrappers::SparseDirectMUMPS>
-        (new PETScWrappers::SparseDirectMUMPS(*ho_cn[i], mpi_communicator));
-        if (transport_model_name=="fo" ||
-            (transport_model_name=="ep" && have_reflective_bc))
-          ho_direct[i]->set_symmetric_mode (false);
-        else
-          ho_direct[i]->set_symmetric_mode (true);
-        ho_direct_init[i] = true;
-      }
-      ho_direct[i]->solve (*ho_syses[i],
-                           *ho_psis[i],
-                           *ho_rhses[i]);
+      // the factors of an identical operator
+      ho_direct[i] = ho_direct[op];
+      ho_direct_init[i] = true;
+      first_solve = false;
     }
-    // the ho_linear_iters are for reporting linear solver status, test purpose only
-    if (ho_linear_solver_name!="direct")
-      ho_linear_iters[i] = ho_cn[i]->last_step ();
+    if (!ho_direct_init[i])
+    {
+      ho_direct[i] = std_cxx11::shared_ptr<PETScWrappers::SparseDirectMUMPS>
+      (new PETScWrappers::SparseDirectMUMPS(*ho_cn[i], mpi_communicator));
+      ho_direct[i]->set_symmetric_mode (is_ho_symmetric ());
+      ho_direct_init[i] = true;
+    }
+    ho_direct[i]->solve (ho_sys, ho_psi, ho_rhs);
+    if (first_solve)
+      ho_direct_bytes += MemoryReport::get_current_rss () - rss_before;
   }
 }
 
+std::vector<unsigned int> PreconditionerSolver::get_ho_linear_iters ()
+{
+  return ho_linear_iters;
+}
+
+std::vector<double> PreconditionerSolver::get_ho_solve_times ()
+{
+  return ho_solve_times;
+}
+
+std::vector<double> PreconditionerSolver::get_ho_final_residuals ()
+{
+  return ho_final_residuals;
+}
+
+std::vector<bool> PreconditionerSolver::get_ho_convergence_failures ()
+{
+  return ho_convergence_failures;
+}
+
+double PreconditionerSolver::get_ho_preconditioner_memory ()
+{
+  return ho_preconditioner_bytes;
+}
+
+double PreconditionerSolver::get_ho_direct_memory ()
+{
+  return ho_direct_bytes;
+}
+
 // the following section is for NDA solving/preconditioning
 // Unlike HO system, preconditioner will be reinit every outer
 // iteration
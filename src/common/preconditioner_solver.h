@@ -6,9 +6,12 @@
 #include <deal.II/lac/petsc_precondition.h>
 #include <deal.II/lac/petsc_solver.h>
 #include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/timer.h>
 
 #include <vector>
 #include <string>
+#include <utility>
 
 using namespace dealii;
 
@@ -21,13 +24,57 @@ public:
   ~PreconditionerSolver ();
   
   // HO solver related member functions
+  // with "auto" solver or preconditioner names, times trial solves of a few
+  // components for every candidate pair and keeps the one with the smallest
+  // predicted total solve time; does nothing otherwise
+  void select_ho_solver
+  (std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+   std::vector<PETScWrappers::MPI::Vector*> &ho_rhses,
+   ConditionalOStream &pcout);
+  
+  // sets up the preconditioners not set up component-wise yet and the
+  // solver controls
   void initialize_ho_preconditioners
   (std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
    std::vector<PETScWrappers::MPI::Vector*> &ho_rhses);
   
+  // component-wise setup while the matrices are still being assembled:
+  // prepare once, then set up every component as soon as its matrix is done
+  void prepare_ho_preconditioners ();
+  void setup_ho_preconditioner (unsigned int i,
+                                PETScWrappers::MPI::SparseMatrix &ho_sys);
+  
+  // components with identical operators: ho_operator_of[i] is the component
+  // whose preconditioner or factors component i uses, i itself if unique
+  void set_ho_operator_map (const std::vector<unsigned int> &ho_operator_of);
+  
+  // after a small change of the matrices, the next
+  // initialize_ho_preconditioners only sets up the components not kept, and
+  // the kept ones are reused as they are by the solves; MUMPS factors are
+  // always rebuilt
+  void keep_ho_preconditioners (const std::vector<bool> &is_kept);
+  
+  // with "HO solver autotune", times every solver/preconditioner pair on a
+  // few components with their current right hand sides, switches all
+  // components to the fastest and records it; to be called before the first
+  // ho_solve, does nothing once tuned or when a recorded choice was loaded
+  void autotune_ho_solver
+  (std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+   std::vector<PETScWrappers::MPI::Vector*> &ho_psis,
+   std::vector<PETScWrappers::MPI::Vector*> &ho_rhses,
+   ConditionalOStream &pcout);
+  // true until autotune_ho_solver has seen the right hand sides of all
+  // components
+  bool is_autotune_pending ();
+  
   void ho_solve (std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
                  std::vector<PETScWrappers::MPI::Vector*> &ho_psis,
                  std::vector<PETScWrappers::MPI::Vector*> &ho_rhses);
+  // solves only the listed components, e.g. the directions of one group
+  void ho_solve (std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+                 std::vector<PETScWrappers::MPI::Vector*> &ho_psis,
+                 std::vector<PETScWrappers::MPI::Vector*> &ho_rhses,
+                 const std::vector<unsigned int> &components);
   
   // NDA solver related member functions
   void reinit_nda_preconditioners
@@ -40,7 +87,42 @@ public:
    PETScWrappers::MPI::Vector &nda_rhs,
    unsigned int &g);
   
+  std::string get_ho_linear_solver_name ();
+  std::string get_ho_preconditioner_name ();
+  
+  // memory held by HO preconditioners and MUMPS factors, estimated from the
+  // growth of the resident set size during their setup
+  double get_ho_preconditioner_memory ();
+  double get_ho_direct_memory ();
+  
+  // per-component statistics of the latest ho_solve call
+  std::vector<unsigned int> get_ho_linear_iters ();
+  std::vector<double> get_ho_solve_times ();
+  std::vector<double> get_ho_final_residuals ();
+  std::vector<bool> get_ho_convergence_failures ();
+  
 private:
+  void resize_ho_preconditioners ();
+  void share_ho_preconditioner (unsigned int i, unsigned int op);
+  // PCSetReusePreconditioner of the preconditioner of component i
+  void set_ho_preconditioner_reuse (unsigned int i, bool is_reused);
+  void initialize_ho_preconditioner (unsigned int i,
+                                     PETScWrappers::MPI::SparseMatrix &ho_sys);
+  void solve_ho_component (unsigned int i,
+                           PETScWrappers::MPI::SparseMatrix &ho_sys,
+                           PETScWrappers::MPI::Vector &ho_psi,
+                           PETScWrappers::MPI::Vector &ho_rhs);
+  bool is_ho_symmetric ();
+  void load_autotuned_ho_solver ();
+  // returns the index of the candidate with the smallest predicted time
+  unsigned int time_ho_candidates
+  (std::vector<std::pair<std::string, std::string> > &candidates,
+   std::vector<unsigned int> &samples,
+   std::vector<PETScWrappers::MPI::SparseMatrix*> &ho_syses,
+   std::vector<PETScWrappers::MPI::Vector*> &trial_psis,
+   std::vector<PETScWrappers::MPI::Vector*> &trial_rhses,
+   ConditionalOStream &pcout);
+  
   const unsigned int n_group;
   const unsigned int n_total_ho_vars;
   const bool do_nda;
@@ -48,6 +130,16 @@ private:
   bool have_reflective_bc;
   double ho_ssor_omega;
   double nda_ssor_omega;
+  double ho_preconditioner_bytes;
+  double ho_direct_bytes;
+  // cost model of the "auto" selection
+  unsigned int ho_expected_solves;
+  unsigned int ho_max_direct_dofs;
+  unsigned int ho_min_dofs_per_proc;
+  bool do_autotune;
+  bool is_autotuned;
+  std::string autotune_key;
+  std::string autotune_filename;
   
   std::string transport_model_name;
   std::string ho_linear_solver_name;
@@ -56,9 +148,16 @@ private:
   std::string nda_preconditioner_name;
   
   std::vector<bool> ho_direct_init;
+  std::vector<bool> ho_preconditioner_ready;
+  std::vector<unsigned int> ho_operator_of;
+  // components that own their operator, i.e. the setups and factorizations
+  unsigned int n_unique_ho_operators;
   std::vector<bool> nda_direct_init;
   std::vector<unsigned int> ho_linear_iters;
   std::vector<unsigned int> nda_linear_iters;
+  std::vector<double> ho_solve_times;
+  std::vector<double> ho_final_residuals;
+  std::vector<bool> ho_convergence_failures;
   
   // HO solver related variables
   std::vector<std_cxx11::shared_ptr<SolverControl> > ho_cn;
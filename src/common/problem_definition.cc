@@ -18,11 +18,20 @@ n_azi(prm.get_integer("angular quadrature order")),
 is_eigen_problem(prm.get_bool("do eigenvalue calculations")),
 do_nda(prm.get_bool("do NDA")),
 do_print_sn_quad(prm.get_bool("do print angular quadrature info")),
+do_print_memory_report(prm.get_bool("do print memory report")),
+do_hardware_counters(prm.get_bool("do hardware counters")),
 have_reflective_bc(prm.get_bool("have reflective BC")),
 p_order(prm.get_integer("finite element polynomial degree")),
 global_refinements(prm.get_integer("uniform refinements")),
-output_namebase(prm.get("output file name base"))
+output_namebase(prm.get("output file name base")),
+telemetry_filename(prm.get("linear solver telemetry file name")),
+convergence_filename(prm.get("convergence history file name")),
+comm_ledger_filename(prm.get("communication ledger file name"))
 {
+  std::string level_name = prm.get ("log level");
+  log_level = (level_name=="error" ? log_error :
+               (level_name=="info" ? log_info :
+                (level_name=="debug" ? log_debug : log_trace)));
 }
 
 ProblemDefinition::~ProblemDefinition()
@@ -38,8 +47,13 @@ void ProblemDefinition::declare_parameters (ParameterHandler &prm)
   {
     prm.declare_entry ("problem dimension", "2", Patterns::Integer(), "1D is not implemented");
     prm.declare_entry ("transport model", "ep", Patterns::Selection("ep"), "valid names such as ep");
-    prm.declare_entry ("HO linear solver name", "cg", Patterns::Selection("cg|gmres|bicgstab|direct"), "solers");
-    prm.declare_entry ("HO preconditioner name", "amg", Patterns::Selection("amg|parasails|bjacobi|jacobi|bssor"), "precond names");
+    prm.declare_entry ("HO linear solver name", "cg", Patterns::Selection("cg|gmres|bicgstab|direct|auto"), "solers, auto picks one from trial solves");
+    prm.declare_entry ("HO preconditioner name", "amg", Patterns::Selection("amg|parasails|bjacobi|jacobi|bssor|auto"), "precond names, auto picks one from trial solves");
+    prm.declare_entry ("HO auto expected solves", "20", Patterns::Integer (), "solves per component the auto solver selection assumes for the whole run");
+    prm.declare_entry ("HO auto max direct DoFs", "200000", Patterns::Integer (), "largest component size for which auto selection tries MUMPS");
+    prm.declare_entry ("HO auto min DoFs per process", "10000", Patterns::Integer (), "auto selection warns below this many DoFs per component and process");
+    prm.declare_entry ("HO solver autotune", "false", Patterns::Bool (), "time all HO solver/preconditioner pairs in the first sweep and keep the fastest");
+    prm.declare_entry ("HO autotune file name", "", Patterns::Anything (), "file recording autotuned pairs per problem class for later runs, none if empty");
     prm.declare_entry ("HO ssor factor", "1.0", Patterns::Double (), "damping factor of Block SSOR for HO");
     prm.declare_entry ("NDA linear solver name", "none", Patterns::Selection("none|gmres|bicgstab|direct"), "NDA linear solers");
     prm.declare_entry ("NDA preconditioner name", "none", Patterns::Selection("none|amg|parasails|bjacobi|jacobi|bssor"), "precond names");
@@ -58,10 +72,28 @@ void ProblemDefinition::declare_parameters (ParameterHandler &prm)
     prm.declare_entry ("number of cells for x, y, z directions", "", Patterns::List (Patterns::Integer ()), "Geotry is hyper rectangle defined by how many cells exist per direction");
     prm.declare_entry ("number of materials", "1", Patterns::Integer (), "must be a positive integer");
     prm.declare_entry ("do print angular quadrature info", "true", Patterns::Bool(), "Boolean to determine if printing angular quadrature information");
+    prm.declare_entry ("do print memory report", "false", Patterns::Bool(), "Boolean to determine if printing memory usage by subsystem after each setup stage");
+    prm.declare_entry ("do hardware counters", "false", Patterns::Bool(), "Boolean to determine if reading Linux perf counters around assembly, RHS generation and HO solves");
+    prm.declare_entry ("log level", "info", Patterns::Selection("error|info|debug|trace"), "screen output: info prints iteration progress, debug adds diagnostics needing extra global reductions, trace adds per-component progress");
     prm.declare_entry ("is mesh generated by deal.II", "true", Patterns::Bool(), "Boolean to determine if generating mesh in dealii or read in mesh");
     //prm.declare_entry ("use explicit reflective boundary condition or not", "true", Patterns::Bool(), "");
     prm.declare_entry ("output file name base", "solu", Patterns::Anything(), "name base of the output file");
     prm.declare_entry ("mesh file name", "mesh.msh", Patterns::Anything(), ".msh file name for read-in mesh");
+    prm.declare_entry ("linear solver telemetry file name", "", Patterns::Anything(), "CSV file for per-component HO linear solver statistics; empty to disable");
+    prm.declare_entry ("convergence history file name", "", Patterns::Anything(), "CSV file for SI/PI convergence history; empty to disable");
+    prm.declare_entry ("communication ledger file name", "", Patterns::Anything(), "CSV file for MPI traffic per phase and outer iteration; empty to disable");
+    prm.declare_entry ("operator cache directory", "", Patterns::Anything(), "directory caching assembled HO matrices between runs, no caching if empty");
+    prm.declare_entry ("HO preconditioner refresh threshold", "0.1", Patterns::Double (0.0), "batch mode: preconditioners of a group are set up again when the largest relative change of its sigma_t exceeds this");
+    prm.declare_entry ("do critical search", "false", Patterns::Bool(), "eigenvalue problems: scale sigma_t and sigma_s of the search materials until keff is 1");
+    prm.declare_entry ("critical search material IDs", "", Patterns::List (Patterns::Integer (1)), "materials, counted from 1 as in the material id map, whose cross sections are scaled, all if empty");
+    prm.declare_entry ("critical search initial scalings", "1.0, 1.1", Patterns::List (Patterns::Double (0.0)), "the two scalings the secant search starts from");
+    prm.declare_entry ("critical search tolerance", "1.0e-5", Patterns::Double (0.0), "the search stops once |keff - 1| is below this");
+    prm.declare_entry ("critical search max trials", "20", Patterns::Integer (1), "eigenvalue solves the search may take");
+    prm.declare_entry ("reduced order model", "false", Patterns::Bool(), "batch mode: after the training cases, solve in a POD basis of their angular fluxes and fall back to full solves when the HO residual is too large");
+    prm.declare_entry ("ROM training cases", "2", Patterns::Integer (1), "cases solved in full before the reduced-order model is built");
+    prm.declare_entry ("ROM error tolerance", "1.0e-4", Patterns::Double (0.0), "largest relative HO residual of an accepted reduced solution");
+    prm.declare_entry ("ROM POD tolerance", "1.0e-10", Patterns::Double (0.0), "largest fraction of the snapshot energy the reduced basis may discard, positive");
+    prm.declare_entry ("threads per process", "1", Patterns::Integer (1), "above 1, components are assembled while preconditioners of earlier ones are set up, and scattering sources of later groups are integrated while earlier groups are solved");
   }
   // FixIt: for current deal.II code, we don't consider reading mesh
   
@@ -94,7 +126,7 @@ void ProblemDefinition::declare_parameters (ParameterHandler &prm)
       for (unsigned int gin=0; gin<ngrp; ++gin)
       {
         std::ostringstream osm;
-        osm << "g_in=" << gin + 1;
+        osm << "g_in " << gin + 1;
         prm.declare_entry (osm.str(), "", Patterns::List(Patterns::Double()), "multigroup sigma_s");
       }
     }
@@ -188,11 +220,41 @@ bool ProblemDefinition::get_print_sn_quad_bool ()
   return do_print_sn_quad;
 }
 
+bool ProblemDefinition::get_print_memory_report_bool ()
+{
+  return do_print_memory_report;
+}
+
+LogLevel ProblemDefinition::get_log_level ()
+{
+  return log_level;
+}
+
+bool ProblemDefinition::get_hardware_counters_bool ()
+{
+  return do_hardware_counters;
+}
+
 std::string ProblemDefinition::get_transport_model ()
 {
   return transport_model_name;
 }
 
+std::string ProblemDefinition::get_linear_solver_telemetry_filename ()
+{
+  return telemetry_filename;
+}
+
+std::string ProblemDefinition::get_convergence_history_filename ()
+{
+  return convergence_filename;
+}
+
+std::string ProblemDefinition::get_comm_ledger_filename ()
+{
+  return comm_ledger_filename;
+}
+
 std::string ProblemDefinition::get_output_namebase ()
 {
   return output_namebase;
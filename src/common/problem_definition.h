@@ -20,6 +20,9 @@ const unsigned int ngrp = 30;
 const unsigned int z_levels = 30;
 const unsigned int y_levels = 100;
 
+// screen output levels, each one includes the ones before it
+enum LogLevel {log_error, log_info, log_debug, log_trace};
+
 class ProblemDefinition
 {
 public:
@@ -35,11 +38,17 @@ public:
   std::string get_output_namebase ();
   std::string get_discretization ();
   std::string get_aq_name ();
+  std::string get_linear_solver_telemetry_filename ();
+  std::string get_convergence_history_filename ();
+  std::string get_comm_ledger_filename ();
   bool get_nda_bool ();
   bool get_eigen_problem_bool ();
   bool get_reflective_bool ();
   bool get_print_sn_quad_bool ();
+  bool get_print_memory_report_bool ();
+  bool get_hardware_counters_bool ();
   bool get_generated_mesh_bool ();
+  LogLevel get_log_level ();
   unsigned int get_sn_order ();
   unsigned int get_n_dir ();
   unsigned int get_n_group ();
@@ -52,12 +61,18 @@ private:
   std::string discretization;
   std::string mesh_filename;
   std::string output_namebase;
+  std::string telemetry_filename;
+  std::string convergence_filename;
+  std::string comm_ledger_filename;
   bool is_mesh_generated;
   bool do_print_sn_quad;
+  bool do_print_memory_report;
+  bool do_hardware_counters;
   bool is_explicit_reflective;
   bool is_eigen_problem;
   bool do_nda;
   bool have_reflective_bc;
+  LogLevel log_level;
   unsigned int n_azi;
   unsigned int n_group;
   unsigned int n_material;
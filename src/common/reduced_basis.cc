@@ -0,0 +1,163 @@
+#include <deal.II/lac/lapack_full_matrix.h>
+
+#include <petscvec.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "reduced_basis.h"
+
+ReducedBasis::ReducedBasis (MPI_Comm &mpi_communicator)
+:
+mpi_communicator(mpi_communicator)
+{
+}
+
+ReducedBasis::~ReducedBasis ()
+{
+}
+
+double ReducedBasis::local_dot (const PETScWrappers::MPI::Vector &a,
+                                const PETScWrappers::MPI::Vector &b)
+{
+  const PetscScalar *a_values, *b_values;
+  VecGetArrayRead (static_cast<const Vec&>(a), &a_values);
+  VecGetArrayRead (static_cast<const Vec&>(b), &b_values);
+  double dot = 0.0;
+  for (unsigned int i=0; i<a.local_size(); ++i)
+    dot += a_values[i] * b_values[i];
+  VecRestoreArrayRead (static_cast<const Vec&>(a), &a_values);
+  VecRestoreArrayRead (static_cast<const Vec&>(b), &b_values);
+  return dot;
+}
+
+void ReducedBasis::add_snapshot (const PETScWrappers::MPI::Vector &snapshot)
+{
+  snapshots.push_back (std_cxx11::shared_ptr<PETScWrappers::MPI::Vector>
+                       (new PETScWrappers::MPI::Vector (snapshot)));
+}
+
+unsigned int ReducedBasis::n_snapshots ()
+{
+  return snapshots.size ();
+}
+
+void ReducedBasis::compress (double tol)
+{
+  const unsigned int n = snapshots.size ();
+  AssertThrow (n>0, ExcMessage ("need snapshots to compress"));
+  AssertThrow (tol>0.0, ExcMessage ("the POD tolerance has to be positive"));
+  std::vector<double> correlation (n * n, 0.0);
+  for (unsigned int i=0; i<n; ++i)
+    for (unsigned int j=0; j<=i; ++j)
+      correlation[i*n+j] = correlation[j*n+i] = local_dot (*snapshots[i], *snapshots[j]);
+  MPI_Allreduce (MPI_IN_PLACE, &correlation[0], n * n, MPI_DOUBLE, MPI_SUM,
+                 mpi_communicator);
+
+  LAPACKFullMatrix<double> c (n, n);
+  double trace = 0.0;
+  for (unsigned int i=0; i<n; ++i)
+  {
+    for (unsigned int j=0; j<n; ++j)
+      c(i,j) = correlation[i*n+j];
+    trace += correlation[i*n+i];
+  }
+  AssertThrow (trace>0.0, ExcMessage ("all snapshots are zero"));
+  // eigenvalues ascending, with their eigenvectors as columns; those below
+  // the round-off of the correlation matrix would become noise modes after
+  // the scaling by 1/sqrt(eigenvalue)
+  Vector<double> eigenvalues;
+  FullMatrix<double> eigenvectors;
+  c.compute_eigenvalues_symmetric (1.0e-12 * trace, 2.0 * trace + 1.0, 0.0,
+                                   eigenvalues, eigenvectors);
+
+  // largest modes until the rest carries at most tol of the energy
+  basis.clear ();
+  double discarded = 0.0;
+  for (unsigned int j=0; j<eigenvalues.size(); ++j)
+    discarded += eigenvalues(j);
+  for (int j=eigenvalues.size()-1; j>=0 && discarded>tol*trace; --j)
+  {
+    discarded -= eigenvalues(j);
+    std_cxx11::shared_ptr<PETScWrappers::MPI::Vector> v
+    (new PETScWrappers::MPI::Vector (*snapshots[0]));
+    *v = 0.0;
+    for (unsigned int i=0; i<n; ++i)
+      v->add (eigenvectors(i,j) / std::sqrt (eigenvalues(j)), *snapshots[i]);
+    // the modes are orthonormal only up to the conditioning of the
+    // snapshots; two Gram-Schmidt passes, one reduction each, restore it
+    const unsigned int r = basis.size ();
+    for (unsigned int pass=0; pass<2 && r>0; ++pass)
+    {
+      std::vector<double> products (r, 0.0);
+      for (unsigned int b=0; b<r; ++b)
+        products[b] = local_dot (*basis[b], *v);
+      MPI_Allreduce (MPI_IN_PLACE, &products[0], r, MPI_DOUBLE, MPI_SUM,
+                     mpi_communicator);
+      for (unsigned int b=0; b<r; ++b)
+        v->add (-products[b], *basis[b]);
+    }
+    // a mode mostly made of the previous ones carries no new information,
+    // nor do the smaller ones after it
+    const double norm = v->l2_norm ();
+    if (norm<0.5)
+      break;
+    *v /= norm;
+    basis.push_back (v);
+  }
+  AssertThrow (basis.size()>0, ExcMessage ("all snapshots are zero"));
+}
+
+unsigned int ReducedBasis::size ()
+{
+  return basis.size ();
+}
+
+const PETScWrappers::MPI::Vector &ReducedBasis::get_vector (unsigned int j)
+{
+  return *basis[j];
+}
+
+void ReducedBasis::project (PETScWrappers::MPI::SparseMatrix &matrix,
+                            FullMatrix<double> &reduced)
+{
+  const unsigned int r = basis.size ();
+  std::vector<double> products (r * r, 0.0);
+  PETScWrappers::MPI::Vector av (*basis[0]);
+  for (unsigned int j=0; j<r; ++j)
+  {
+    matrix.vmult (av, *basis[j]);
+    for (unsigned int i=0; i<r; ++i)
+      products[i*r+j] = local_dot (*basis[i], av);
+  }
+  MPI_Allreduce (MPI_IN_PLACE, &products[0], r * r, MPI_DOUBLE, MPI_SUM,
+                 mpi_communicator);
+  reduced.reinit (r, r);
+  for (unsigned int i=0; i<r; ++i)
+    for (unsigned int j=0; j<r; ++j)
+      reduced(i,j) = products[i*r+j];
+}
+
+void ReducedBasis::project (const PETScWrappers::MPI::Vector &x,
+                            Vector<double> &reduced)
+{
+  const unsigned int r = basis.size ();
+  std::vector<double> products (std::max (r, 1u), 0.0);
+  for (unsigned int j=0; j<r; ++j)
+    products[j] = local_dot (*basis[j], x);
+  MPI_Allreduce (MPI_IN_PLACE, &products[0], r, MPI_DOUBLE, MPI_SUM,
+                 mpi_communicator);
+  reduced.reinit (r);
+  for (unsigned int j=0; j<r; ++j)
+    reduced(j) = products[j];
+}
+
+void ReducedBasis::expand (const Vector<double> &coefficients,
+                           PETScWrappers::MPI::Vector &x)
+{
+  AssertThrow (coefficients.size()==basis.size(),
+               ExcMessage ("need one coefficient per basis vector"));
+  x = 0.0;
+  for (unsigned int j=0; j<basis.size(); ++j)
+    x.add (coefficients(j), *basis[j]);
+}
@@ -0,0 +1,59 @@
+#ifndef __reduced_basis_h__
+#define __reduced_basis_h__
+
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/std_cxx11/shared_ptr.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/petsc_parallel_sparse_matrix.h>
+#include <deal.II/lac/petsc_parallel_vector.h>
+
+#include <vector>
+
+using namespace dealii;
+
+// Proper orthogonal decomposition of distributed snapshots by the method of
+// snapshots: the eigenpairs of the small correlation matrix S^T S give the
+// dominant left singular vectors of S without a distributed SVD. The basis
+// is orthonormal in the Euclidean inner product of the DoF vectors, which is
+// the one of the Galerkin projections below.
+//
+// Inner products are summed locally and reduced in one allreduce per
+// product family, not one per pair.
+class ReducedBasis
+{
+public:
+  ReducedBasis (MPI_Comm &mpi_communicator);
+  ~ReducedBasis ();
+
+  void add_snapshot (const PETScWrappers::MPI::Vector &snapshot);
+  unsigned int n_snapshots ();
+  // collective: keeps the fewest modes s.t. the discarded part of the
+  // snapshot energy is at most tol of the total; modes below 1e-12 of the
+  // total energy are always discarded
+  void compress (double tol);
+  unsigned int size ();
+  const PETScWrappers::MPI::Vector &get_vector (unsigned int j);
+
+  // collective: V^T A V
+  void project (PETScWrappers::MPI::SparseMatrix &matrix,
+                FullMatrix<double> &reduced);
+  // collective: V^T x
+  void project (const PETScWrappers::MPI::Vector &x,
+                Vector<double> &reduced);
+  // x = V a
+  void expand (const Vector<double> &coefficients,
+               PETScWrappers::MPI::Vector &x);
+
+private:
+  // sum over the locally owned entries only
+  static double local_dot (const PETScWrappers::MPI::Vector &a,
+                           const PETScWrappers::MPI::Vector &b);
+
+  std::vector<std_cxx11::shared_ptr<PETScWrappers::MPI::Vector> > snapshots;
+  std::vector<std_cxx11::shared_ptr<PETScWrappers::MPI::Vector> > basis;
+
+  MPI_Comm mpi_communicator;
+};
+
+#endif //__reduced_basis_h__
@@ -57,7 +57,7 @@ void MaterialProperties::process_material_properties
         for (unsigned int gin=0; gin<n_group; ++gin)
         {
           std::ostringstream os;
-          os << "g_in=" << gin + 1;
+          os << "g_in " << gin + 1;
           std::vector<std::string> strings = Utilities::split_string_list (prm.get(os.str()));
           AssertThrow (strings.size()==n_group,
                        ExcMessage("sigma_s should have n_group entries per in group"));
@@ -200,7 +200,6 @@ void MaterialProperties::process_eigen_material_properties
           std::vector<std::string> strings = Utilities::split_string_list (prm.get (os.str ()));
           AssertThrow (strings.size () == n_group,
                        ExcMessage ("n_group is not equal to group number of ksi"));
-          std::vector<double> tmp;
           for (unsigned int g=0; g<n_group; ++g)
             tmp[g] = std::atof (strings[g].c_str ());
         }
@@ -221,7 +220,6 @@ void MaterialProperties::process_eigen_material_properties
           std::vector<std::string> strings = Utilities::split_string_list (prm.get (os.str ()));
           AssertThrow (strings.size () == n_group,
                        ExcMessage ("n_group is not equal to group number of nusigf"));
-          std::vector<double> tmp;
           for (unsigned int g=0; g<n_group; ++g)
             tmp[g] = std::atof (strings[g].c_str ());
         }
@@ -274,7 +272,7 @@ void MaterialProperties::process_eigen_material_properties
           tmp[gin][g] = all_ksi[m][g] * all_nusigf[m][gin];
           tmp_per_ster[gin][g] = tmp[gin][g] / (4.0 * pi);
         }
-    all_ksi_nusigf.push_back (tmp_per_ster);
+    all_ksi_nusigf.push_back (tmp);
     all_ksi_nusigf_per_ster.push_back (tmp_per_ster);
   }
 }
@@ -2,9 +2,10 @@
 #include "even_parity.h"
 
 template <int dim>
-EvenParity<dim>::EvenParity (ParameterHandler &prm)
+EvenParity<dim>::EvenParity (ParameterHandler &prm,
+                             MPI_Comm mpi_communicator)
 :
-TransportBase<dim>(prm)
+TransportBase<dim>(prm, mpi_communicator)
 {
 }
 
@@ -13,6 +14,33 @@ EvenParity<dim>::~EvenParity ()
 {
 }
 
+template <int dim>
+std::vector<double> EvenParity<dim>::get_ho_operator_key (unsigned int k)
+{
+  unsigned int g = this->get_component_group (k);
+  unsigned int i_dir = this->get_component_direction (k);
+  std::vector<double> key;
+  for (unsigned int m=0; m<this->n_material; ++m)
+  {
+    key.push_back (this->all_sigt[m][g]);
+    key.push_back (this->all_inv_sigt[m][g]);
+  }
+  Tensor<1, dim> omega = this->omega_i[i_dir];
+  for (unsigned int d=0; d<dim; ++d)
+    if (omega[d]!=0.0)
+    {
+      if (omega[d]<0.0)
+        omega *= -1.0;
+      break;
+    }
+  for (unsigned int d=0; d<dim; ++d)
+    key.push_back (omega[d]);
+  // the interface penalty, DFEM only
+  if (this->tensor_norms.size()>i_dir)
+    key.push_back (this->tensor_norms[i_dir]);
+  return key;
+}
+
 template <int dim>
 void EvenParity<dim>::pre_assemble_cell_matrices
 (const std_cxx11::shared_ptr<FEValues<dim> > fv,
@@ -194,116 +222,137 @@ void EvenParity<dim>::integrate_interface_bilinear_form
 template <int dim>
 void EvenParity<dim>::generate_ho_rhs ()
 {
-  for (unsigned int g=0; g<this->n_group; ++g)
-    for (unsigned int i_dir=0; i_dir<this->n_dir; ++i_dir)
+  // only the zeroth direction of a group is integrated, the others are copies
+  if (!this->do_nda)
+  {
+    this->evaluate_sflx_at_qp ();
+    std::vector<Vector<double> > cell_rhses;
+    std::vector<LA::MPI::Vector*> group_rhses;
+    for (unsigned int g=0; g<this->n_group; ++g)
     {
-      unsigned int k = this->get_component_index (i_dir, g);
-      if (i_dir==0 && !this->do_nda)
+      unsigned int k = this->get_component_index (0, g);
+      *(this->vec_ho_rhs[k]) = 0.0;
+      integrate_ho_group_source (g, cell_rhses);
+      for (unsigned int ic=0; ic<this->local_cells.size (); ++ic)
       {
-        *(this->vec_ho_rhs[k]) = 0.0;
-        for (unsigned int ic=0; ic<this->local_cells.size (); ++ic)
-        {
-          Vector<double> cell_rhs (this->dofs_per_cell);
-          typename DoFHandler<dim>::active_cell_iterator cell = this->local_cells[ic];
-          cell->get_dof_indices (this->local_dof_indices);
-          this->fv->reinit (cell);
-          unsigned int mid = cell->material_id ();
-          std::vector<std::vector<double> > local_sflxes
-          (this->n_group, std::vector<double>(this->n_q));
-          for (unsigned int gin=0; gin<this->n_group; ++gin)
-            this->fv->get_function_values (this->sflx_proc[gin], local_sflxes[gin]);
-          
-          for (unsigned int qi=0; qi<this->n_q; ++qi)
-          {
-            double q_at_qp = 0.0;
-            for (unsigned int gin=0; gin<this->n_group; ++gin)
-              q_at_qp += (this->all_sigs_per_ster[mid][gin][g]<1.0e-13?0.0:
-                          (this->all_sigs_per_ster[mid][gin][g] * local_sflxes[gin][qi]));
-            for (unsigned int i=0; i<this->dofs_per_cell; ++i)
-              cell_rhs (i) += this->vec_test_at_qp[ic](qi, i) * q_at_qp;
-          }
-          this->vec_ho_rhs[k]->add (this->local_dof_indices, cell_rhs);
-        }// local cells
-        this->vec_ho_rhs[k]->compress (VectorOperation::add);
-        *(this->vec_ho_rhs[k]) += *(this->vec_ho_fixed_rhs[k]);
-      }// zeroth direction per group
-      else
-        *(this->vec_ho_rhs[k]) = *(this->vec_ho_rhs[this->get_component_index(0, g)]);
-    // Note that reflective boundary condition is carreid out using explicit reflective
-    // algorithm. See Memo 2 for details.
-    }// i_dir
+        this->local_cells[ic]->get_dof_indices (this->local_dof_indices);
+        this->rhs_exchange_ptr->add (g, this->local_dof_indices, cell_rhses[ic],
+                                     *(this->vec_ho_rhs[k]));
+      }
+      group_rhses.push_back (this->vec_ho_rhs[k]);
+    }// group
+    // off-process entries of all groups in one exchange
+    this->rhs_exchange_ptr->exchange (group_rhses);
+    this->comm_ptr->record ("generate_ho_rhs", "batched vector exchange", 1,
+                            this->rhs_exchange_ptr->get_send_bytes ());
+  }
+  for (unsigned int g=0; g<this->n_group; ++g)
+    finish_ho_rhs (g);
+}
+
+template <int dim>
+void EvenParity<dim>::integrate_ho_group_source
+(unsigned int g,
+ std::vector<Vector<double> > &cell_rhses)
+{
+  cell_rhses.resize (this->local_cells.size (), Vector<double> (this->dofs_per_cell));
+  for (unsigned int ic=0; ic<this->local_cells.size (); ++ic)
+  {
+    cell_rhses[ic] = 0.0;
+    unsigned int mid = this->local_cells[ic]->material_id ();
+    for (unsigned int qi=0; qi<this->n_q; ++qi)
+    {
+      double q_at_qp = 0.0;
+      for (unsigned int gin=0; gin<this->n_group; ++gin)
+        q_at_qp += (this->all_sigs_per_ster[mid][gin][g]<1.0e-13?0.0:
+                    (this->all_sigs_per_ster[mid][gin][g] * this->sflx_at_qp[ic][gin][qi]));
+      for (unsigned int i=0; i<this->dofs_per_cell; ++i)
+        cell_rhses[ic](i) += this->vec_test_at_qp[ic](qi, i) * q_at_qp;
+    }
+  }
+}
+
+template <int dim>
+void EvenParity<dim>::finish_ho_rhs (unsigned int g)
+{
+  unsigned int k = this->get_component_index (0, g);
+  if (!this->do_nda)
+    *(this->vec_ho_rhs[k]) += *(this->vec_ho_fixed_rhs[k]);
+  // Note that reflective boundary condition is carreid out using explicit reflective
+  // algorithm. See Memo 2 for details.
+  for (unsigned int i_dir=1; i_dir<this->n_dir; ++i_dir)
+    *(this->vec_ho_rhs[this->get_component_index(i_dir, g)]) = *(this->vec_ho_rhs[k]);
 }
 
 template <int dim>
 void EvenParity<dim>::generate_ho_fixed_source ()
 {
+  // only the zeroth direction of a group is integrated, the others are copies
   for (unsigned int g=0; g<this->n_group; ++g)
-    for (unsigned int i_dir=0; i_dir<this->n_dir; ++i_dir)
+  {
+    unsigned int k = this->get_component_index (0, g);
+    *(this->vec_ho_fixed_rhs[k]) = 0.0;
+    for (unsigned int ic=0; ic<this->local_cells.size (); ++ic)
     {
-      unsigned int k = this->get_component_index (i_dir, g);
-      if (i_dir==0)
+      Vector<double> cell_rhs (this->dofs_per_cell);
+      typename DoFHandler<dim>::active_cell_iterator cell = this->local_cells[ic];
+      unsigned int mid = cell->material_id ();
+      
+      if ((this->is_eigen_problem && this->is_material_fissile[mid]) ||
+          (!this->is_eigen_problem &&
+           (this->do_nda || (!this->do_nda && this->all_q_per_ster[mid][g]>1.0e-13))))
       {
-        *(this->vec_ho_fixed_rhs[k]) = 0.0;
-        for (unsigned int ic=0; ic<this->local_cells.size (); ++ic)
+        this->fv->reinit (cell);
+        cell->get_dof_indices (this->local_dof_indices);
+        std::vector<std::vector<double> > local_sflxes (this->n_group, std::vector<double>(this->n_q));
+        for (unsigned int gin=0; gin<this->n_group; ++gin)
+        {
+          if (this->do_nda)
+            this->fv->get_function_values (this->lo_sflx_proc[gin], local_sflxes[gin]);
+          else if (!this->do_nda && this->is_eigen_problem)
+            this->fv->get_function_values (this->sflx_proc_prev_gen[gin], local_sflxes[gin]);
+        }
+        
+        for (unsigned int qi=0; qi<this->n_q; ++qi)
         {
-          Vector<double> cell_rhs (this->dofs_per_cell);
-          typename DoFHandler<dim>::active_cell_iterator cell = this->local_cells[ic];
-          unsigned int mid = cell->material_id ();
-          
-          if ((this->is_eigen_problem && this->is_material_fissile[mid]) ||
-              (!this->is_eigen_problem &&
-               (this->do_nda || (!this->do_nda && this->all_q_per_ster[mid][g]>1.0e-13))))
+          double q_at_qp = 0.0;
+          // calculate pointwise source per spatial quadrature point
+          if (this->do_nda)
           {
-            this->fv->reinit (cell);
-            cell->get_dof_indices (this->local_dof_indices);
-            std::vector<std::vector<double> > local_sflxes (this->n_group, std::vector<double>(this->n_q));
-            for (unsigned int gin=0; gin<this->n_group; ++gin)
-            {
-              if (this->do_nda)
-                this->fv->get_function_values (this->lo_sflx_proc[gin], local_sflxes[gin]);
-              else if (!this->do_nda && this->is_eigen_problem)
-                this->fv->get_function_values (this->sflx_proc_prev_gen[gin], local_sflxes[gin]);
-            }
-            
-            for (unsigned int qi=0; qi<this->n_q; ++qi)
-            {
-              double q_at_qp = 0.0;
-              // calculate pointwise source per spatial quadrature point
-              if (this->do_nda)
-              {
-                if (this->is_eigen_problem)
-                  for (unsigned int gin=0; gin<this->n_group; ++gin)
-                    q_at_qp += (this->scat_scaled_fiss_transfer_per_ster[mid][gin][g]<1.0e-13?0.0:
-                                (this->scat_scaled_fiss_transfer_per_ster[mid][gin][g] *
-                                 local_sflxes[gin][qi]));
-                else
-                  for (unsigned int gin=0; gin<this->n_group; ++gin)
-                    q_at_qp += (this->all_sigs_per_ster[mid][gin][g]<1.0e-13?0.0:
-                                (this->all_sigs_per_ster[mid][gin][g] *
-                                 local_sflxes[gin][qi]));
-              }
-              else// no NDA
-              {
-                if (this->is_eigen_problem)// fission source is the fixed source
-                  for (unsigned int gin=0; gin<this->n_group; ++gin)
-                    q_at_qp += (!this->is_material_fissile[mid]?0.0:
-                                (this->scaled_fiss_transfer_per_ster[mid][gin][g] *
-                                 local_sflxes[gin][qi]));
-                else
-                  q_at_qp += this->all_q_per_ster[mid][g];
-              }
-              for (unsigned int i=0; i<this->dofs_per_cell; ++i)
-                cell_rhs (i) += this->vec_test_at_qp[ic](qi, i) * q_at_qp;
-            }
-            this->vec_ho_fixed_rhs[k]->add (this->local_dof_indices, cell_rhs);
-          }// when to calculate rhs
-        }// loop over local cells
-        this->vec_ho_fixed_rhs[k]->compress (VectorOperation::add);
-      }// first direction per group
-      else
-        *(this->vec_ho_fixed_rhs[k]) =
-        *(this->vec_ho_fixed_rhs[this->get_component_index(0, g)]);
-    }
+            if (this->is_eigen_problem)
+              for (unsigned int gin=0; gin<this->n_group; ++gin)
+                q_at_qp += (this->scat_scaled_fiss_transfer_per_ster[mid][gin][g]<1.0e-13?0.0:
+                            (this->scat_scaled_fiss_transfer_per_ster[mid][gin][g] *
+                             local_sflxes[gin][qi]));
+            else
+              for (unsigned int gin=0; gin<this->n_group; ++gin)
+                q_at_qp += (this->all_sigs_per_ster[mid][gin][g]<1.0e-13?0.0:
+                            (this->all_sigs_per_ster[mid][gin][g] *
+                             local_sflxes[gin][qi]));
+          }
+          else// no NDA
+          {
+            if (this->is_eigen_problem)// fission source is the fixed source
+              for (unsigned int gin=0; gin<this->n_group; ++gin)
+                q_at_qp += (!this->is_material_fissile[mid]?0.0:
+                            (this->scaled_fiss_transfer_per_ster[mid][gin][g] *
+                             local_sflxes[gin][qi]));
+            else
+              q_at_qp += this->all_q_per_ster[mid][g];
+          }
+          for (unsigned int i=0; i<this->dofs_per_cell; ++i)
+            cell_rhs (i) += this->vec_test_at_qp[ic](qi, i) * q_at_qp;
+        }
+        this->vec_ho_fixed_rhs[k]->add (this->local_dof_indices, cell_rhs);
+      }// when to calculate rhs
+    }// loop over local cells
+    this->vec_ho_fixed_rhs[k]->compress (VectorOperation::add);
+    this->comm_ptr->record ("generate_ho_fixed_source", "vector compress", 1,
+                            this->vector_stash_bytes);
+    for (unsigned int i_dir=1; i_dir<this->n_dir; ++i_dir)
+      *(this->vec_ho_fixed_rhs[this->get_component_index(i_dir, g)]) =
+      *(this->vec_ho_fixed_rhs[k]);
+  }// group
 }
 
 template class EvenParity<2>;
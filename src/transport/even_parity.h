@@ -7,7 +7,8 @@ template<int dim>
 class EvenParity : public TransportBase<dim>
 {
 public:
-  EvenParity (ParameterHandler &prm);
+  EvenParity (ParameterHandler &prm,
+              MPI_Comm mpi_communicator=MPI_COMM_WORLD);
   ~EvenParity ();
   
   void pre_assemble_cell_matrices
@@ -46,8 +47,15 @@ public:
    FullMatrix<double> &vn_up,
    FullMatrix<double> &vn_un);
   
+  // sigma_t of the group in every material and the direction up to its
+  // sign, since even parity operators are quadratic in omega
+  std::vector<double> get_ho_operator_key (unsigned int k);
+  
   void generate_ho_fixed_source ();
   void generate_ho_rhs ();
+  void integrate_ho_group_source (unsigned int g,
+                                  std::vector<Vector<double> > &cell_rhses);
+  void finish_ho_rhs (unsigned int g);
 };
 
 #endif // __even_parity__
@@ -1,4 +1,5 @@
 #include <deal.II/fe/fe_values.h>
+#include <deal.II/base/multithread_info.h>
 
 #include <boost/algorithm/string.hpp>
 #include <deal.II/dofs/dof_tools.h>
@@ -8,6 +9,8 @@
 #include <deal.II/lac/solver_bicgstab.h>
 
 #include <algorithm>
+#include <cmath>
+#include <iomanip>
 
 #include "transport_base.h"
 #include "../aqdata/aq_base.h"
@@ -16,9 +19,10 @@
 using namespace dealii;
 
 template <int dim>
-TransportBase<dim>::TransportBase (ParameterHandler &prm)
+TransportBase<dim>::TransportBase (ParameterHandler &prm,
+                                   MPI_Comm mpi_communicator)
 :
-mpi_communicator (MPI_COMM_WORLD),
+mpi_communicator (mpi_communicator),
 triangulation (mpi_communicator,
                typename Triangulation<dim>::MeshSmoothing
                (Triangulation<dim>::smoothing_on_refinement |
@@ -43,7 +47,59 @@ pcout(std::cout,
   (new MeshGenerator<dim>(prm));
   mat_ptr = std_cxx11::shared_ptr<MaterialProperties>
   (new MaterialProperties(prm));
+  mem_ptr = std_cxx11::shared_ptr<MemoryReport>
+  (new MemoryReport(mpi_communicator));
   this->process_input ();
+  hwc_ptr = std_cxx11::shared_ptr<HardwareCounters>
+  (new HardwareCounters(mpi_communicator, do_hardware_counters,
+                        prm.get_integer ("threads per process")));
+  comm_ptr = std_cxx11::shared_ptr<CommLedger>
+  (new CommLedger(mpi_communicator, comm_ledger_filename));
+  cache_ptr = std_cxx11::shared_ptr<OperatorCache>
+  (new OperatorCache(prm, mpi_communicator));
+  vector_stash_bytes = halo_bytes = 0.0;
+  are_operators_reused = is_warm_start = false;
+  search_trial = 0;
+  pre_refresh_threshold = prm.get_double ("HO preconditioner refresh threshold");
+  do_critical_search = prm.get_bool ("do critical search");
+  if (do_critical_search)
+  {
+    std::vector<int> search_ids = Utilities::string_to_int
+    (Utilities::split_string_list (prm.get ("critical search material IDs")));
+    is_search_material.resize (n_material, search_ids.size ()==0);
+    // IDs count from 1 as in the material id map
+    for (unsigned int i=0; i<search_ids.size(); ++i)
+    {
+      AssertThrow (search_ids[i]>=1 && (unsigned int)search_ids[i]<=n_material,
+                   ExcMessage ("critical search material IDs have to be between 1 and the number of materials"));
+      is_search_material[search_ids[i]-1] = true;
+    }
+    search_scalings = Utilities::string_to_double
+    (Utilities::split_string_list (prm.get ("critical search initial scalings")));
+    AssertThrow (search_scalings.size ()==2,
+                 ExcMessage ("the critical search needs two initial scalings"));
+    search_tol = prm.get_double ("critical search tolerance");
+    n_max_search_trials = prm.get_integer ("critical search max trials");
+  }
+  critical_scaling = 1.0;
+  do_rom = prm.get_bool ("reduced order model");
+  AssertThrow (!do_rom || !do_nda,
+               ExcMessage ("the reduced-order model is only implemented without NDA"));
+  AssertThrow (!do_rom || !do_critical_search,
+               ExcMessage ("the reduced-order model cannot be combined with the critical search"));
+  n_rom_training = prm.get_integer ("ROM training cases");
+  rom_tol = prm.get_double ("ROM error tolerance");
+  rom_pod_tol = prm.get_double ("ROM POD tolerance");
+  AssertThrow (!do_rom || rom_pod_tol>0.0,
+               ExcMessage ("ROM POD tolerance has to be positive"));
+  n_rom_cases = n_rom_iters = 0;
+  is_rom_built = is_rom_solved = are_preconditioners_stale = false;
+  is_snapshot_pending = false;
+  rom_indicator = 0.0;
+  // MPI_InitFinalize limits deal.II to one thread
+  n_threads = prm.get_integer ("threads per process");
+  if (n_threads>1)
+    MultithreadInfo::set_thread_limit (n_threads);
   sflx_proc.resize (n_group);
   sflx_proc_prev_gen.resize (n_group);
 }
@@ -69,8 +125,14 @@ void TransportBase<dim>::process_input ()
     do_nda = def_ptr->get_nda_bool ();
     is_eigen_problem = def_ptr->get_eigen_problem_bool ();
     do_print_sn_quad = def_ptr->get_print_sn_quad_bool ();
+    do_print_memory_report = def_ptr->get_print_memory_report_bool ();
+    do_hardware_counters = def_ptr->get_hardware_counters_bool ();
+    log_level = def_ptr->get_log_level ();
     global_refinements = def_ptr->get_uniform_refinement ();
     namebase = def_ptr->get_output_namebase ();
+    telemetry_filename = def_ptr->get_linear_solver_telemetry_filename ();
+    convergence_filename = def_ptr->get_convergence_history_filename ();
+    comm_ledger_filename = def_ptr->get_comm_ledger_filename ();
 
     // from angular quadrature data
     n_azi = aqd_ptr->get_sn_order ();
@@ -93,9 +155,14 @@ void TransportBase<dim>::process_input ()
     reflective_direction_index = aqd_ptr->get_reflective_direction_index_map ();
   }
 
-  // material properties
+  relative_position_to_id = msh_ptr->get_id_map ();
+  process_material_properties ();
+}
+
+template <int dim>
+void TransportBase<dim>::process_material_properties ()
+{
   {
-    relative_position_to_id = msh_ptr->get_id_map ();
     all_sigt = mat_ptr->get_sigma_t ();
     all_inv_sigt = mat_ptr->get_inv_sigma_t ();
     all_sigs = mat_ptr->get_sigma_s ();
@@ -129,6 +196,8 @@ void TransportBase<dim>::initialize_aq (ParameterHandler &prm)
 template <int dim>
 void TransportBase<dim>::report_system ()
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << "SN quadrature order: " << n_azi << std::endl
   << "Number of angles: " << n_dir << std::endl
   << "Number of groups: " << n_group << std::endl;
@@ -154,18 +223,122 @@ void TransportBase<dim>::report_system ()
   radio ("is eigenvalue problem?", is_eigen_problem);
 }
 
+template <int dim>
+void TransportBase<dim>::report_memory (std::string stage_name)
+{
+  // sizes are local to this process; MemoryReport reduces them to min/max
+  // over all processes
+  double sys_values = 0.0, sys_indices = 0.0;
+  for (unsigned int k=0; k<vec_ho_unique_sys.size(); ++k)
+  {
+    MatInfo info;
+    MatGetInfo (*vec_ho_unique_sys[k], MAT_LOCAL, &info);
+    sys_values += info.nz_allocated * sizeof(PetscScalar);
+    sys_indices += (info.nz_allocated * sizeof(PetscInt) +
+                    (vec_ho_unique_sys[k]->local_size () + 1) * sizeof(PetscInt));
+  }
+
+  double aflx_bytes = 0.0;
+  for (unsigned int k=0; k<vec_aflx.size(); ++k)
+    aflx_bytes += vec_aflx[k]->local_size () * sizeof(PetscScalar);
+
+  double rhs_bytes = 0.0;
+  for (unsigned int k=0; k<vec_ho_rhs.size(); ++k)
+    rhs_bytes += ((vec_ho_rhs[k]->local_size () +
+                   vec_ho_fixed_rhs[k]->local_size ()) * sizeof(PetscScalar));
+
+  double sflx_bytes = 0.0;
+  for (unsigned int g=0; g<vec_ho_sflx.size(); ++g)
+    sflx_bytes += ((vec_ho_sflx[g]->local_size () +
+                    vec_ho_sflx_old[g]->local_size () +
+                    vec_ho_sflx_prev_gen[g]->local_size ()) * sizeof(PetscScalar));
+
+  double sflx_proc_bytes = 0.0;
+  for (unsigned int g=0; g<n_group; ++g)
+    sflx_proc_bytes += (sflx_proc[g].memory_consumption () +
+                        sflx_proc_prev_gen[g].memory_consumption ());
+
+  double test_bytes = 0.0;
+  for (unsigned int ic=0; ic<vec_test_at_qp.size(); ++ic)
+    test_bytes += vec_test_at_qp[ic].memory_consumption ();
+
+  // cross sections are tiny compared to the rest but are replicated on
+  // every process
+  double xs_bytes = 0.0;
+  for (unsigned int m=0; m<n_material; ++m)
+  {
+    xs_bytes += 2 * n_group * sizeof(double);
+    xs_bytes += 2 * n_group * n_group * sizeof(double);
+    if (is_eigen_problem)
+      xs_bytes += (n_group + 2 * n_group * n_group) * sizeof(double);
+    else
+      xs_bytes += 2 * n_group * sizeof(double);
+  }
+
+  mem_ptr->clear ();
+  mem_ptr->add_entry ("HO matrices (values)", sys_values);
+  mem_ptr->add_entry ("HO matrices (indices)", sys_indices);
+  mem_ptr->add_entry ("HO angular fluxes", aflx_bytes);
+  mem_ptr->add_entry ("HO rhs and fixed rhs", rhs_bytes);
+  mem_ptr->add_entry ("HO scalar fluxes", sflx_bytes);
+  mem_ptr->add_entry ("sflx_proc replicas", sflx_proc_bytes);
+  mem_ptr->add_entry ("test functions at qp", test_bytes);
+  mem_ptr->add_entry ("HO preconditioners (RSS growth)",
+                      sol_ptr->get_ho_preconditioner_memory ());
+  mem_ptr->add_entry ("MUMPS factors (RSS growth)",
+                      sol_ptr->get_ho_direct_memory ());
+  mem_ptr->add_entry ("cross-section tables", xs_bytes);
+  mem_ptr->add_entry ("triangulation", triangulation.memory_consumption ());
+  mem_ptr->add_entry ("DoF handler", dof_handler.memory_consumption ());
+  mem_ptr->print (stage_name, pcout);
+}
+
 template <int dim>
 void TransportBase<dim>::setup_system ()
 {
   radio ("setup system");
   initialize_dealii_objects ();
   initialize_system_matrices_vectors ();
+  // one exchange plan per assembly loop, reused for all components and, for
+  // the scattering source, all iterations; the matrix exchanges come with
+  // the matrices
+  rhs_exchange_ptr = std_cxx11::shared_ptr<OffProcessExchange>
+  (new OffProcessExchange (mpi_communicator, local_dofs, n_group));
+  group_rhs_exchange_ptr = std_cxx11::shared_ptr<OffProcessExchange>
+  (new OffProcessExchange (mpi_communicator, local_dofs, 1));
+  component_exchange_ptr = std_cxx11::shared_ptr<OffProcessExchange>
+  (new OffProcessExchange (mpi_communicator, local_dofs, 1));
+  if (comm_ptr->is_enabled ())
+    estimate_comm_volumes ();
+}
+
+template <int dim>
+void TransportBase<dim>::estimate_comm_volumes ()
+{
+  // PETSc stashes every value added to a row owned by another process with
+  // its index until the next compress; matrices and the RHS go through the
+  // OffProcessExchange objects, which count their bytes themselves
+  const double vector_entry = sizeof (PetscScalar) + sizeof (PetscInt);
+  double n_vector_entries = 0.0;
+  for (unsigned int ic=0; ic<local_cells.size(); ++ic)
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = local_cells[ic];
+    cell->get_dof_indices (local_dof_indices);
+    for (unsigned int i=0; i<dofs_per_cell; ++i)
+      if (!local_dofs.is_element (local_dof_indices[i]))
+        n_vector_entries += 1.0;
+  }
+  vector_stash_bytes = n_vector_entries * vector_entry;
+  // a matrix-vector product gathers the ghost entries of the operand
+  IndexSet ghost_dofs = relevant_dofs;
+  ghost_dofs.subtract_set (local_dofs);
+  halo_bytes = ghost_dofs.n_elements () * sizeof (PetscScalar);
 }
 
 template <int dim>
 void TransportBase<dim>::initialize_system_matrices_vectors ()
 {
-  DynamicSparsityPattern dsp (relevant_dofs);
+  dsp.reinit (relevant_dofs.size (), relevant_dofs.size (), relevant_dofs);
 
   if (discretization=="dfem")
   {
@@ -216,7 +389,6 @@ void TransportBase<dim>::initialize_system_matrices_vectors ()
 
     for (unsigned int i_dir=0; i_dir<n_dir; ++i_dir)
     {
-      vec_ho_sys.push_back (new LA::MPI::SparseMatrix);
       vec_aflx.push_back (new LA::MPI::Vector);
       vec_ho_rhs.push_back (new LA::MPI::Vector);
       vec_ho_fixed_rhs.push_back (new LA::MPI::Vector);
@@ -248,10 +420,6 @@ void TransportBase<dim>::initialize_system_matrices_vectors ()
 
     for (unsigned int i_dir=0; i_dir<n_dir; ++i_dir)
     {
-      vec_ho_sys[get_component_index(i_dir, g)]->reinit(local_dofs,
-                                                        local_dofs,
-                                                        dsp,
-                                                        mpi_communicator);
       vec_aflx[get_component_index(i_dir, g)]->reinit(local_dofs,
                                                       mpi_communicator);
       vec_ho_rhs[get_component_index(i_dir, g)]->reinit (local_dofs,
@@ -260,20 +428,447 @@ void TransportBase<dim>::initialize_system_matrices_vectors ()
                                                                mpi_communicator);
     }
   }
+
+  find_identical_operators ();
+  allocate_ho_matrices ();
+}
+
+template <int dim>
+void TransportBase<dim>::allocate_ho_matrices ()
+{
+  for (unsigned int u=0; u<vec_ho_unique_sys.size(); ++u)
+    delete vec_ho_unique_sys[u];
+  vec_ho_unique_sys.clear ();
+  vec_ho_sys.resize (n_total_ho_vars);
+  for (unsigned int u=0; u<ho_unique_operators.size(); ++u)
+  {
+    unsigned int k = ho_unique_operators[u];
+    vec_ho_sys[k] = new LA::MPI::SparseMatrix;
+    vec_ho_sys[k]->reinit (local_dofs,
+                           local_dofs,
+                           dsp,
+                           mpi_communicator);
+    vec_ho_unique_sys.push_back (vec_ho_sys[k]);
+  }
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+    vec_ho_sys[k] = vec_ho_sys[ho_operator_of[k]];
+  sol_ptr->set_ho_operator_map (ho_operator_of);
+  
+  // the exchange plans depend on the number of matrices
+  sys_exchange_ptr = std_cxx11::shared_ptr<OffProcessExchange>
+  (new OffProcessExchange (mpi_communicator, local_dofs, vec_ho_unique_sys.size ()));
+  interface_exchange_ptr = std_cxx11::shared_ptr<OffProcessExchange>
+  (new OffProcessExchange (mpi_communicator, local_dofs, vec_ho_unique_sys.size ()));
+}
+
+template <int dim>
+void TransportBase<dim>::update_ho_operators
+(std::vector<std::vector<double> > &old_sigt,
+ std::vector<std::vector<double> > &old_inv_sigt)
+{
+  are_operators_reused = false;
+  std::vector<unsigned int> old_operator_of = ho_operator_of;
+  find_identical_operators ();
+  if (ho_operator_of!=old_operator_of)
+  {
+    allocate_ho_matrices ();
+    assemble_ho_system ();
+    is_group_pre_stale.assign (n_group, true);
+  }
+  else if (!reassemble_changed_materials (old_sigt, old_inv_sigt))
+  {
+    for (unsigned int u=0; u<vec_ho_unique_sys.size(); ++u)
+      *vec_ho_unique_sys[u] = 0.0;
+    assemble_ho_system ();
+    is_group_pre_stale.assign (n_group, true);
+  }
+}
+
+template <int dim>
+bool TransportBase<dim>::reassemble_changed_materials
+(std::vector<std::vector<double> > &old_sigt,
+ std::vector<std::vector<double> > &old_inv_sigt)
+{
+  std::vector<bool> is_material_changed (n_material, false);
+  std::vector<bool> is_group_changed (n_group, false);
+  // largest relative change of sigma_t per group since its preconditioners
+  // were set up, s.t. small steps do not add up unnoticed
+  std::vector<double> group_change (n_group, 0.0);
+  if (pre_sigt.size ()==0)
+    is_group_pre_stale.assign (n_group, true);
+  for (unsigned int m=0; m<n_material; ++m)
+    for (unsigned int g=0; g<n_group; ++g)
+    {
+      if (all_sigt[m][g]!=old_sigt[m][g])
+        is_material_changed[m] = is_group_changed[g] = true;
+      if (pre_sigt.size ()>0)
+        group_change[g] = std::max (group_change[g],
+                                    std::fabs (all_sigt[m][g] - pre_sigt[m][g]) /
+                                    pre_sigt[m][g]);
+    }
+  
+  std::vector<unsigned int> changed_cells;
+  for (unsigned int ic=0; ic<local_cells.size(); ++ic)
+  {
+    bool is_changed = is_material_changed[local_cells[ic]->material_id ()];
+    // the interface terms of DFEM also see the neighbors
+    if (discretization=="dfem")
+      for (unsigned int fn=0; fn<GeometryInfo<dim>::faces_per_cell; ++fn)
+        if (!local_cells[ic]->at_boundary(fn) &&
+            is_material_changed[local_cells[ic]->neighbor(fn)->material_id ()])
+          is_changed = true;
+    if (is_changed)
+      changed_cells.push_back (ic);
+  }
+  // every cell costs two integrations here, one in a full assembly
+  double n_changed = Utilities::MPI::sum (1.0 * changed_cells.size (), mpi_communicator);
+  double n_cells = Utilities::MPI::sum (1.0 * local_cells.size (), mpi_communicator);
+  comm_ptr->record ("reassemble changed materials", "count reduction", 2, 2 * sizeof (double));
+  if (n_changed>0.5*n_cells)
+    return false;
+  radio ("Reassembling cells touching changed materials", n_changed);
+  
+  std::vector<unsigned int> changed_ops;
+  std::vector<LA::MPI::SparseMatrix*> changed_syses;
+  for (unsigned int u=0; u<ho_unique_operators.size(); ++u)
+    if (is_group_changed[get_component_group (ho_unique_operators[u])])
+    {
+      changed_ops.push_back (u);
+      changed_syses.push_back (vec_ho_unique_sys[u]);
+    }
+  // the assembly exchanges keep the pattern of a full loop, so a subset
+  // needs its own
+  OffProcessExchange delta_exchange (mpi_communicator, local_dofs,
+                                     changed_ops.size ());
+  
+  std::vector<std::vector<FullMatrix<double> > >
+  streaming_at_qp (n_q, std::vector<FullMatrix<double> > (n_dir, FullMatrix<double> (dofs_per_cell, dofs_per_cell)));
+  std::vector<FullMatrix<double> >
+  collision_at_qp (n_q, FullMatrix<double>(dofs_per_cell, dofs_per_cell));
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = local_cells[0];
+    fv->reinit (cell);
+    pre_assemble_cell_matrices (fv, cell, streaming_at_qp, collision_at_qp);
+  }
+  
+  // the local matrices are integrated twice, the second time with the old
+  // cross sections swapped in, and their difference is added
+  std::vector<FullMatrix<double> > local_mats (4, FullMatrix<double> (dofs_per_cell, dofs_per_cell));
+  std::vector<FullMatrix<double> > old_mats (4, FullMatrix<double> (dofs_per_cell, dofs_per_cell));
+  for (unsigned int c=0; c<changed_ops.size(); ++c)
+  {
+    unsigned int k = ho_unique_operators[changed_ops[c]];
+    unsigned int g = get_component_group (k);
+    unsigned int i_dir = get_component_direction (k);
+    for (unsigned int i=0; i<changed_cells.size(); ++i)
+    {
+      unsigned int ic = changed_cells[i];
+      typename DoFHandler<dim>::active_cell_iterator cell = local_cells[ic];
+      fv->reinit (cell);
+      cell->get_dof_indices (local_dof_indices);
+      for (unsigned int pass=0; pass<2; ++pass)
+      {
+        FullMatrix<double> &mat = (pass==0 ? local_mats[0] : old_mats[0]);
+        mat = 0;
+        integrate_cell_bilinear_form (fv, cell, mat, i_dir, g,
+                                      streaming_at_qp, collision_at_qp);
+        if (is_cell_at_bd[ic])
+          for (unsigned int fn=0; fn<GeometryInfo<dim>::faces_per_cell; ++fn)
+            if (cell->at_boundary(fn))
+            {
+              fvf->reinit (cell, fn);
+              integrate_boundary_bilinear_form (fvf, cell, fn, mat, i_dir, g);
+            }
+        all_sigt.swap (old_sigt);
+        all_inv_sigt.swap (old_inv_sigt);
+      }
+      local_mats[0].add (-1.0, old_mats[0]);
+      delta_exchange.add (c, local_dof_indices, local_dof_indices,
+                          local_mats[0], *vec_ho_sys[k]);
+      
+      if (discretization!="dfem")
+        continue;
+      for (unsigned int fn=0; fn<GeometryInfo<dim>::faces_per_cell; ++fn)
+        if (!cell->at_boundary(fn) &&
+            cell->neighbor(fn)->id()<cell->id() &&
+            (is_material_changed[cell->material_id ()] ||
+             is_material_changed[cell->neighbor(fn)->material_id ()]))
+        {
+          fvf->reinit (cell, fn);
+          typename DoFHandler<dim>::cell_iterator
+          neigh = cell->neighbor(fn);
+          neigh->get_dof_indices (neigh_dof_indices);
+          fvf_nei->reinit (neigh, cell->neighbor_face_no(fn));
+          for (unsigned int pass=0; pass<2; ++pass)
+          {
+            std::vector<FullMatrix<double> > &mats = (pass==0 ? local_mats : old_mats);
+            for (unsigned int j=0; j<4; ++j)
+              mats[j] = 0;
+            integrate_interface_bilinear_form (fvf, fvf_nei, cell, neigh, fn,
+                                               i_dir, g,
+                                               mats[0], mats[1], mats[2], mats[3]);
+            all_sigt.swap (old_sigt);
+            all_inv_sigt.swap (old_inv_sigt);
+          }
+          for (unsigned int j=0; j<4; ++j)
+            local_mats[j].add (-1.0, old_mats[j]);
+          delta_exchange.add (c, local_dof_indices, local_dof_indices,
+                              local_mats[0], *vec_ho_sys[k]);
+          delta_exchange.add (c, local_dof_indices, neigh_dof_indices,
+                              local_mats[1], *vec_ho_sys[k]);
+          delta_exchange.add (c, neigh_dof_indices, local_dof_indices,
+                              local_mats[2], *vec_ho_sys[k]);
+          delta_exchange.add (c, neigh_dof_indices, neigh_dof_indices,
+                              local_mats[3], *vec_ho_sys[k]);
+        }
+    }
+  }
+  delta_exchange.exchange (changed_syses);
+  comm_ptr->record ("reassemble changed materials", "batched matrix exchange", 1,
+                    delta_exchange.get_send_bytes ());
+  
+  // preconditioners built for the old matrices are kept while they are
+  // close enough and no earlier case asked for their refresh
+  for (unsigned int g=0; g<n_group; ++g)
+    if (group_change[g]>pre_refresh_threshold)
+      is_group_pre_stale[g] = true;
+  std::vector<bool> is_kept (n_total_ho_vars);
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+    is_kept[k] = !is_group_pre_stale[get_component_group (k)];
+  sol_ptr->keep_ho_preconditioners (is_kept);
+  return true;
+}
+
+template <int dim>
+void TransportBase<dim>::find_identical_operators ()
+{
+  // exact comparison of the coefficients, so shared operators are the ones
+  // assembly would have produced anyway
+  std::map<std::vector<double>, unsigned int> operator_of_key;
+  ho_operator_of.resize (n_total_ho_vars);
+  ho_unique_operators.clear ();
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+  {
+    std::pair<std::map<std::vector<double>, unsigned int>::iterator, bool> it =
+    operator_of_key.insert (std::make_pair (get_ho_operator_key (k), k));
+    ho_operator_of[k] = it.first->second;
+    if (it.second)
+      ho_unique_operators.push_back (k);
+  }
+  unsigned int n_unique = ho_unique_operators.size ();
+  if (n_unique<n_total_ho_vars)
+    radio ("Distinct HO operators", n_unique);
+}
+
+template <int dim>
+std::vector<double> TransportBase<dim>::get_ho_operator_key (unsigned int k)
+{
+  return std::vector<double> (1, k);
 }
 
 template <int dim>
 void TransportBase<dim>::assemble_ho_system ()
 {
-  radio ("Assemble volumetric bilinear forms");
-  assemble_ho_volume_boundary ();
+  vec_test_at_qp.clear ();
+  if (cache_ptr->load (vec_ho_unique_sys))
+  {
+    radio ("Loaded HO system from operator cache", cache_ptr->get_key ());
+    fill_test_at_qp ();
+    return;
+  }
+  AssertThrow (discretization!="dfem" || transport_model_name=="ep",
+               ExcMessage("DFEM is only implemented for even parity"));
+  // nothing to overlap with when the choice is still open or MUMPS factors
+  // in the first solve
+  std::string solver_name = sol_ptr->get_ho_linear_solver_name ();
+  if (n_threads>1 && solver_name!="direct" && solver_name!="auto" &&
+      sol_ptr->get_ho_preconditioner_name ()!="auto")
+  {
+    radio ("Assemble HO system pipelined with preconditioner setup");
+    hwc_ptr->start ("pipelined setup");
+    pipelined_setup ();
+    hwc_ptr->stop ("pipelined setup");
+  }
+  else
+  {
+    radio ("Assemble volumetric bilinear forms");
+    hwc_ptr->start ("assemble volume/boundary");
+    assemble_ho_volume_boundary ();
+    hwc_ptr->stop ("assemble volume/boundary");
+    
+    if (discretization=="dfem")
+    {
+      radio ("Assemble cell interface bilinear forms for DFEM");
+      hwc_ptr->start ("assemble interface");
+      assemble_ho_interface ();
+      hwc_ptr->stop ("assemble interface");
+    }
+  }
+  if (cache_ptr->is_enabled ())
+  {
+    cache_ptr->store (vec_ho_unique_sys);
+    radio ("Stored HO system in operator cache", cache_ptr->get_key ());
+  }
+}
 
-  if (discretization=="dfem")
+template <int dim>
+void TransportBase<dim>::pipelined_setup ()
+{
+  std::vector<std::vector<FullMatrix<double> > >
+  streaming_at_qp (n_q, std::vector<FullMatrix<double> > (n_dir, FullMatrix<double> (dofs_per_cell, dofs_per_cell)));
+  std::vector<FullMatrix<double> >
+  collision_at_qp (n_q, FullMatrix<double>(dofs_per_cell, dofs_per_cell));
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = local_cells[0];
+    fv->reinit (cell);
+    pre_assemble_cell_matrices (fv, cell, streaming_at_qp, collision_at_qp);
+  }
+  fill_test_at_qp ();
+  sol_ptr->prepare_ho_preconditioners ();
+  
+  // two buffers: the worker fills one while this thread empties the other
+  std::vector<std::vector<FullMatrix<double> > > cell_matrices (2), face_matrices (2);
+  const unsigned int n_unique = ho_unique_operators.size ();
+  Threads::Task<void> task =
+  Threads::new_task (&TransportBase<dim>::integrate_ho_component, *this,
+                     ho_unique_operators[0],
+                     streaming_at_qp, collision_at_qp,
+                     cell_matrices[0], face_matrices[0]);
+  for (unsigned int u=0; u<n_unique; ++u)
   {
-    AssertThrow (transport_model_name=="ep",
-                 ExcMessage("DFEM is only implemented for even parity"));
-    radio ("Assemble cell interface bilinear forms for DFEM");
-    assemble_ho_interface ();
+    unsigned int k = ho_unique_operators[u];
+    task.join ();
+    if (u+1<n_unique)
+      task = Threads::new_task (&TransportBase<dim>::integrate_ho_component, *this,
+                                ho_unique_operators[u+1],
+                                streaming_at_qp, collision_at_qp,
+                                cell_matrices[(u+1)%2], face_matrices[(u+1)%2]);
+    if (log_enabled (log_trace))
+      radio ("Assembling Component",k,"direction",get_component_direction (k),
+             "group",get_component_group (k));
+    add_ho_component (k, cell_matrices[u%2], face_matrices[u%2]);
+    sol_ptr->setup_ho_preconditioner (k, *vec_ho_sys[k]);
+  }
+}
+
+template <int dim>
+void TransportBase<dim>::integrate_ho_component
+(unsigned int k,
+ std::vector<std::vector<FullMatrix<double> > > &streaming_at_qp,
+ std::vector<FullMatrix<double> > &collision_at_qp,
+ std::vector<FullMatrix<double> > &cell_matrices,
+ std::vector<FullMatrix<double> > &face_matrices)
+{
+  // runs on a worker thread, so it cannot share the FEValues objects
+  std_cxx11::shared_ptr<FEValues<dim> > fv_k
+  (new FEValues<dim> (*fe, *q_rule,
+                      update_values | update_gradients |
+                      update_quadrature_points |
+                      update_JxW_values));
+  std_cxx11::shared_ptr<FEFaceValues<dim> > fvf_k
+  (new FEFaceValues<dim> (*fe, *qf_rule,
+                          update_values | update_gradients |
+                          update_quadrature_points | update_normal_vectors |
+                          update_JxW_values));
+  std_cxx11::shared_ptr<FEFaceValues<dim> > fvf_nei_k
+  (new FEFaceValues<dim> (*fe, *qf_rule,
+                          update_values | update_gradients |
+                          update_quadrature_points | update_normal_vectors |
+                          update_JxW_values));
+  unsigned int g = get_component_group (k);
+  unsigned int i_dir = get_component_direction (k);
+  cell_matrices.resize (local_cells.size ());
+  face_matrices.clear ();
+  FullMatrix<double> vp_up (dofs_per_cell, dofs_per_cell);
+  FullMatrix<double> vp_un (dofs_per_cell, dofs_per_cell);
+  FullMatrix<double> vn_up (dofs_per_cell, dofs_per_cell);
+  FullMatrix<double> vn_un (dofs_per_cell, dofs_per_cell);
+  for (unsigned int ic=0; ic<local_cells.size(); ++ic)
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = local_cells[ic];
+    fv_k->reinit (cell);
+    cell_matrices[ic].reinit (dofs_per_cell, dofs_per_cell);
+    integrate_cell_bilinear_form (fv_k, cell, cell_matrices[ic], i_dir, g,
+                                  streaming_at_qp, collision_at_qp);
+    if (is_cell_at_bd[ic])
+      for (unsigned int fn=0; fn<GeometryInfo<dim>::faces_per_cell; ++fn)
+        if (cell->at_boundary(fn))
+        {
+          fvf_k->reinit (cell, fn);
+          integrate_boundary_bilinear_form (fvf_k, cell, fn, cell_matrices[ic],
+                                            i_dir, g);
+        }
+    if (discretization=="dfem")
+      for (unsigned int fn=0; fn<GeometryInfo<dim>::faces_per_cell; ++fn)
+        if (!cell->at_boundary(fn) &&
+            cell->neighbor(fn)->id()<cell->id())
+        {
+          typename DoFHandler<dim>::cell_iterator neigh = cell->neighbor(fn);
+          fvf_k->reinit (cell, fn);
+          fvf_nei_k->reinit (neigh, cell->neighbor_face_no(fn));
+          vp_up = 0;
+          vp_un = 0;
+          vn_up = 0;
+          vn_un = 0;
+          integrate_interface_bilinear_form (fvf_k, fvf_nei_k, cell, neigh, fn,
+                                             i_dir, g,
+                                             vp_up, vp_un, vn_up, vn_un);
+          face_matrices.push_back (vp_up);
+          face_matrices.push_back (vp_un);
+          face_matrices.push_back (vn_up);
+          face_matrices.push_back (vn_un);
+        }
+  }
+}
+
+template <int dim>
+void TransportBase<dim>::add_ho_component
+(unsigned int k,
+ std::vector<FullMatrix<double> > &cell_matrices,
+ std::vector<FullMatrix<double> > &face_matrices)
+{
+  // same face order as integrate_ho_component
+  unsigned int i_face = 0;
+  for (unsigned int ic=0; ic<local_cells.size(); ++ic)
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = local_cells[ic];
+    cell->get_dof_indices (local_dof_indices);
+    component_exchange_ptr->add (0, local_dof_indices, local_dof_indices,
+                                 cell_matrices[ic], *vec_ho_sys[k]);
+    if (discretization=="dfem")
+      for (unsigned int fn=0; fn<GeometryInfo<dim>::faces_per_cell; ++fn)
+        if (!cell->at_boundary(fn) &&
+            cell->neighbor(fn)->id()<cell->id())
+        {
+          cell->neighbor(fn)->get_dof_indices (neigh_dof_indices);
+          component_exchange_ptr->add (0, local_dof_indices, local_dof_indices,
+                                       face_matrices[i_face], *vec_ho_sys[k]);
+          component_exchange_ptr->add (0, local_dof_indices, neigh_dof_indices,
+                                       face_matrices[i_face+1], *vec_ho_sys[k]);
+          component_exchange_ptr->add (0, neigh_dof_indices, local_dof_indices,
+                                       face_matrices[i_face+2], *vec_ho_sys[k]);
+          component_exchange_ptr->add (0, neigh_dof_indices, neigh_dof_indices,
+                                       face_matrices[i_face+3], *vec_ho_sys[k]);
+          i_face += 4;
+        }
+  }
+  std::vector<LA::MPI::SparseMatrix*> component_sys (1, vec_ho_sys[k]);
+  component_exchange_ptr->exchange (component_sys);
+  comm_ptr->record ("assemble HO system", "component matrix exchange", 1,
+                    component_exchange_ptr->get_send_bytes ());
+}
+
+template <int dim>
+void TransportBase<dim>::fill_test_at_qp ()
+{
+  // normally a by-product of assembling the first component
+  for (unsigned int ic=0; ic<local_cells.size(); ++ic)
+  {
+    fv->reinit (local_cells[ic]);
+    vec_test_at_qp.push_back (FullMatrix<double> (n_q, dofs_per_cell));
+    for (unsigned int qi=0; qi<n_q; ++qi)
+      for (unsigned int i=0; i<dofs_per_cell; ++i)
+        vec_test_at_qp[ic](qi, i) = fv->shape_value (i,qi) * fv->JxW (qi);
   }
 }
 
@@ -347,11 +942,13 @@ void TransportBase<dim>::assemble_ho_volume_boundary ()
     pre_assemble_cell_matrices (fv, cell, streaming_at_qp, collision_at_qp);
   }
 
-  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+  for (unsigned int u=0; u<ho_unique_operators.size(); ++u)
   {
+    unsigned int k = ho_unique_operators[u];
     unsigned int g = get_component_group (k);
     unsigned int i_dir = get_component_direction (k);
-    radio ("Assembling Component",k,"direction",i_dir,"group",g);
+    if (log_enabled (log_trace))
+      radio ("Assembling Component",k,"direction",i_dir,"group",g);
     FullMatrix<double> local_mat (dofs_per_cell, dofs_per_cell);
 
     for (unsigned int ic=0; ic<local_cells.size(); ++ic)
@@ -381,18 +978,26 @@ void TransportBase<dim>::assemble_ho_volume_boundary ()
                                               g);
           }
       
-      if (k==0)
+      if (u==0)
         for (unsigned int qi=0; qi<n_q; ++qi)
           for (unsigned int i=0; i<dofs_per_cell; ++i)
             vec_test_at_qp[ic](qi, i) = fv->shape_value (i,qi) * fv->JxW (qi);
       
-      vec_ho_sys[k]->add (local_dof_indices,
-                          local_dof_indices,
-                          local_mat);
+      sys_exchange_ptr->add (u, local_dof_indices, local_dof_indices,
+                             local_mat, *vec_ho_sys[k]);
     }
-    vec_ho_sys[k]->compress (VectorOperation::add);
-    pcout << "sys norm: " << vec_ho_sys[k]->l1_norm () << std::endl;
   }// components
+  // off-process entries of all components in one exchange
+  sys_exchange_ptr->exchange (vec_ho_unique_sys);
+  comm_ptr->record ("assemble HO system", "batched matrix exchange", 1,
+                    sys_exchange_ptr->get_send_bytes ());
+  // l1_norm is a global reduction, only pay for it when asked
+  if (log_enabled (log_debug))
+    for (unsigned int u=0; u<vec_ho_unique_sys.size(); ++u)
+    {
+      pcout << "sys norm: " << vec_ho_unique_sys[u]->l1_norm () << std::endl;
+      comm_ptr->record ("assemble HO system", "norm reduction", 1, sizeof (double));
+    }
 }
 
 // The following is a virtual function for integraing cell bilinear form;
@@ -453,8 +1058,9 @@ void TransportBase<dim>::assemble_ho_interface ()
   FullMatrix<double> vn_up (dofs_per_cell, dofs_per_cell);
   FullMatrix<double> vn_un (dofs_per_cell, dofs_per_cell);
 
-  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+  for (unsigned int u=0; u<ho_unique_operators.size(); ++u)
   {
+    unsigned int k = ho_unique_operators[u];
     unsigned int g = get_component_group (k);
     unsigned int i_dir = get_component_direction (k);
 
@@ -483,25 +1089,23 @@ void TransportBase<dim>::assemble_ho_interface ()
                                              fn,
                                              i_dir, g,/*specific component*/
                                              vp_up, vp_un, vn_up, vn_un);
-          vec_ho_sys[k]->add (local_dof_indices,
-                              local_dof_indices,
-                              vp_up);
+          interface_exchange_ptr->add (u, local_dof_indices, local_dof_indices,
+                                       vp_up, *vec_ho_sys[k]);
 
-          vec_ho_sys[k]->add (local_dof_indices,
-                              neigh_dof_indices,
-                              vp_un);
+          interface_exchange_ptr->add (u, local_dof_indices, neigh_dof_indices,
+                                       vp_un, *vec_ho_sys[k]);
 
-          vec_ho_sys[k]->add (neigh_dof_indices,
-                              local_dof_indices,
-                              vn_up);
+          interface_exchange_ptr->add (u, neigh_dof_indices, local_dof_indices,
+                                       vn_up, *vec_ho_sys[k]);
 
-          vec_ho_sys[k]->add (neigh_dof_indices,
-                              neigh_dof_indices,
-                              vn_un);
+          interface_exchange_ptr->add (u, neigh_dof_indices, neigh_dof_indices,
+                                       vn_un, *vec_ho_sys[k]);
         }// target faces
     }
-    vec_ho_sys[k]->compress(VectorOperation::add);
   }// component
+  interface_exchange_ptr->exchange (vec_ho_unique_sys);
+  comm_ptr->record ("assemble HO system", "batched matrix exchange", 1,
+                    interface_exchange_ptr->get_send_bytes ());
 }
 
 // The following is a virtual function for integrating DG interface for HO system
@@ -529,13 +1133,33 @@ void TransportBase<dim>::generate_moments ()
   AssertThrow(do_nda==false, ExcMessage("Moments are generated only without NDA"));
   if (!do_nda)
     for (unsigned int g=0; g<n_group; ++g)
-    {
-      *vec_ho_sflx_old[g] = *vec_ho_sflx[g];
-      *vec_ho_sflx[g] = 0;
-      for (unsigned int i_dir=0; i_dir<n_dir; ++i_dir)
-        vec_ho_sflx[g]->add (wi[i_dir], *vec_aflx[get_component_index(i_dir, g)]);
-      sflx_proc[g] = *vec_ho_sflx[g];
-    }
+      generate_group_moments (g);
+}
+
+template <int dim>
+void TransportBase<dim>::generate_group_moments (unsigned int g)
+{
+  *vec_ho_sflx_old[g] = *vec_ho_sflx[g];
+  *vec_ho_sflx[g] = 0;
+  for (unsigned int i_dir=0; i_dir<n_dir; ++i_dir)
+    vec_ho_sflx[g]->add (wi[i_dir], *vec_aflx[get_component_index(i_dir, g)]);
+  sflx_proc[g] = *vec_ho_sflx[g];
+  comm_ptr->record ("generate_moments", "all-gather (sflx_proc)", 1,
+                    dof_handler.n_dofs () * sizeof (double));
+}
+
+template <int dim>
+void TransportBase<dim>::evaluate_sflx_at_qp ()
+{
+  sflx_at_qp.resize (local_cells.size (),
+                     std::vector<std::vector<double> >
+                     (n_group, std::vector<double> (n_q)));
+  for (unsigned int ic=0; ic<local_cells.size (); ++ic)
+  {
+    fv->reinit (local_cells[ic]);
+    for (unsigned int g=0; g<n_group; ++g)
+      fv->get_function_values (sflx_proc[g], sflx_at_qp[ic][g]);
+  }
 }
 
 template <int dim>
@@ -543,6 +1167,18 @@ void TransportBase<dim>::generate_ho_rhs ()
 {
 }
 
+template <int dim>
+void TransportBase<dim>::integrate_ho_group_source
+(unsigned int g,
+ std::vector<Vector<double> > &cell_rhses)
+{
+}
+
+template <int dim>
+void TransportBase<dim>::finish_ho_rhs (unsigned int g)
+{
+}
+
 template <int dim>
 void TransportBase<dim>::NDA_PI ()
 {
@@ -581,13 +1217,19 @@ void TransportBase<dim>::generate_ho_fixed_source ()
 template <int dim>
 void TransportBase<dim>::initialize_fiss_process ()
 {
-  for (unsigned int g=0; g<n_group; ++g)
+  // batch cases start from the flux and k of the previous case
+  if (!is_warm_start)
   {
-    *vec_ho_sflx[g] = 1.0;
-    sflx_proc[g] = *vec_ho_sflx[g];
+    for (unsigned int g=0; g<n_group; ++g)
+    {
+      *vec_ho_sflx[g] = 1.0;
+      sflx_proc[g] = *vec_ho_sflx[g];
+      comm_ptr->record ("initialize_fiss_process", "all-gather (sflx_proc)", 1,
+                        dof_handler.n_dofs () * sizeof (double));
+    }
+    keff = 1.0;
   }
   fission_source = estimate_fiss_source (sflx_proc);
-  keff = 1.0;
 }
 
 template <int dim>
@@ -597,6 +1239,8 @@ void TransportBase<dim>::update_ho_moments_in_fiss ()
   {
     *vec_ho_sflx_prev_gen[g] = *vec_ho_sflx[g];
     sflx_proc_prev_gen[g] = *vec_ho_sflx_prev_gen[g];
+    comm_ptr->record ("update_ho_moments_in_fiss", "all-gather (sflx_proc)", 1,
+                      dof_handler.n_dofs () * sizeof (double));
   }
 }
 
@@ -616,20 +1260,32 @@ void TransportBase<dim>::power_iteration ()
   double err_k = 1.0;
   double err_phi = 1.0;
   unsigned int ct = 0;
+  double err_phi_old;
   initialize_fiss_process ();
   while (err_k>err_k_tol || err_phi>err_phi_eigen_tol)
   {
     ct += 1;
+    current_pi_iter = ct;
+    comm_ptr->set_outer_iteration (ct);
+    Timer timer;
+    timer.start ();
     update_ho_moments_in_fiss ();
     scale_fiss_transfer_matrices ();
+    hwc_ptr->start ("generate_ho_fixed_source");
     generate_ho_fixed_source ();
+    hwc_ptr->stop ("generate_ho_fixed_source");
     source_iteration ();
     update_fiss_source_keff ();
+    err_phi_old = err_phi;
     err_phi = estimate_phi_diff (vec_ho_sflx, vec_ho_sflx_prev_gen);
     err_k = std::fabs (keff - keff_prev_gen) / keff;
-    pcout
-    << "PI iter: " << ct << ", k: " << keff
-    << ", err_k: " << err_k << ", err_phi: " << err_phi << std::endl;
+    timer.stop ();
+    record_convergence_history ("PI", ct, timer.wall_time (),
+                                err_phi, err_phi / err_phi_old, err_k);
+    if (log_enabled (log_info))
+      pcout
+      << "PI iter: " << ct << ", k: " << keff
+      << ", err_k: " << err_k << ", err_phi: " << err_phi << std::endl;
     radio ();
   }
 }
@@ -645,21 +1301,178 @@ void TransportBase<dim>::source_iteration ()
   {
     //generate_ho_source ();
     ct += 1;
-    generate_ho_rhs ();
-    sol_ptr->ho_solve (vec_ho_sys,
-                       vec_aflx,
-                       vec_ho_rhs);
-    generate_moments ();
+    total_si_iters += 1;
+    Timer timer;
+    timer.start ();
+    // autotuning needs the right hand sides of all components at once
+    bool is_pipelined = (n_threads>1 && !do_nda &&
+                         !sol_ptr->is_autotune_pending ());
+    try
+    {
+      if (is_pipelined)
+      {
+        hwc_ptr->start ("pipelined sweep");
+        pipelined_sweep ();
+        hwc_ptr->stop ("pipelined sweep");
+      }
+      else
+      {
+        hwc_ptr->start ("generate_ho_rhs");
+        generate_ho_rhs ();
+        hwc_ptr->stop ("generate_ho_rhs");
+        // needs the right hand sides of the first sweep, returns at once later on
+        sol_ptr->autotune_ho_solver (vec_ho_sys, vec_aflx, vec_ho_rhs, pcout);
+        ho_linear_solver_name = sol_ptr->get_ho_linear_solver_name ();
+        ho_preconditioner_name = sol_ptr->get_ho_preconditioner_name ();
+        hwc_ptr->start ("ho_solve");
+        sol_ptr->ho_solve (vec_ho_sys,
+                           vec_aflx,
+                           vec_ho_rhs);
+        hwc_ptr->stop ("ho_solve");
+      }
+    }
+    catch (SolverControl::NoConvergence &exc)
+    {
+      // the sweep with the failed component still gets its telemetry rows
+      record_linear_solver_telemetry (ct);
+      if (telemetry_out.is_open ())
+        telemetry_out.flush ();
+      throw;
+    }
+    if (comm_ptr->is_enabled ())
+    {
+      std::vector<unsigned int> iters = sol_ptr->get_ho_linear_iters ();
+      double n_matvecs = 0.0;
+      for (unsigned int k=0; k<n_total_ho_vars; ++k)
+        n_matvecs += iters[k];
+      comm_ptr->record ("ho_solve", "SpMV halo exchange (est.)",
+                        n_matvecs, n_matvecs * halo_bytes);
+    }
+    record_linear_solver_telemetry (ct);
+    if (!is_pipelined)
+      generate_moments ();
     err_phi_old = err_phi;
     err_phi = estimate_phi_diff (vec_ho_sflx, vec_ho_sflx_old);
     double spectral_radius = err_phi / err_phi_old;
-    pcout
-    << "SI iter: " << ct
-    << ", phi err: " << err_phi
-    << ", spec. rad.: " << spectral_radius << std::endl;
+    timer.stop ();
+    total_iteration_time += timer.wall_time ();
+    record_convergence_history ("SI", ct, timer.wall_time (),
+                                err_phi, spectral_radius, 0.0);
+    if (log_enabled (log_info))
+      pcout
+      << "SI iter: " << ct
+      << ", phi err: " << err_phi
+      << ", spec. rad.: " << spectral_radius << std::endl;
   }
 }
 
+template <int dim>
+void TransportBase<dim>::pipelined_sweep ()
+{
+  // the tasks only read sflx_at_qp, which holds the fluxes of the previous
+  // sweep, so every group sees the same scattering source as in the phased
+  // sweep; PETSc objects and MPI stay on this thread
+  evaluate_sflx_at_qp ();
+  std::vector<std::vector<Vector<double> > > group_cell_rhses (n_group);
+  std::vector<Threads::Task<void> > tasks;
+  for (unsigned int g=0; g<n_group; ++g)
+    tasks.push_back (Threads::new_task (&TransportBase<dim>::integrate_ho_group_source,
+                                        *this, g, group_cell_rhses[g]));
+  for (unsigned int g=0; g<n_group; ++g)
+  {
+    tasks[g].join ();
+    unsigned int k = get_component_index (0, g);
+    *vec_ho_rhs[k] = 0.0;
+    for (unsigned int ic=0; ic<local_cells.size(); ++ic)
+    {
+      local_cells[ic]->get_dof_indices (local_dof_indices);
+      group_rhs_exchange_ptr->add (0, local_dof_indices, group_cell_rhses[g][ic],
+                                   *vec_ho_rhs[k]);
+    }
+    std::vector<LA::MPI::Vector*> group_rhs (1, vec_ho_rhs[k]);
+    group_rhs_exchange_ptr->exchange (group_rhs);
+    comm_ptr->record ("generate_ho_rhs", "group vector exchange", 1,
+                      group_rhs_exchange_ptr->get_send_bytes ());
+    group_cell_rhses[g].clear ();
+    finish_ho_rhs (g);
+    
+    std::vector<unsigned int> components;
+    for (unsigned int i_dir=0; i_dir<n_dir; ++i_dir)
+      components.push_back (get_component_index (i_dir, g));
+    sol_ptr->ho_solve (vec_ho_sys, vec_aflx, vec_ho_rhs, components);
+    generate_group_moments (g);
+  }
+}
+
+template <int dim>
+void TransportBase<dim>::record_linear_solver_telemetry (unsigned int si_ct)
+{
+  std::vector<unsigned int> iters = sol_ptr->get_ho_linear_iters ();
+  std::vector<double> times = sol_ptr->get_ho_solve_times ();
+  std::vector<double> residuals = sol_ptr->get_ho_final_residuals ();
+  std::vector<bool> failures = sol_ptr->get_ho_convergence_failures ();
+
+  std::vector<unsigned int> group_iters (n_group, 0), dir_iters (n_dir, 0);
+  std::vector<double> group_times (n_group, 0.0), dir_times (n_dir, 0.0);
+  unsigned int n_failures = 0;
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+  {
+    unsigned int g = get_component_group (k);
+    unsigned int i_dir = get_component_direction (k);
+    group_iters[g] += iters[k];
+    group_times[g] += times[k];
+    dir_iters[i_dir] += iters[k];
+    dir_times[i_dir] += times[k];
+    n_failures += failures[k] ? 1 : 0;
+    total_linear_iters += iters[k];
+    // only rank 0 has the file opened
+    if (telemetry_out.is_open ())
+      telemetry_out << search_trial << "," << current_pi_iter << ","
+      << si_ct << "," << k << "," << i_dir << "," << g << "," << iters[k]
+      << "," << times[k] << "," << residuals[k] << ","
+      << (failures[k] ? 0 : 1) << "\n";
+  }
+
+  if (log_enabled (log_info))
+  {
+    pcout << "  HO linear iters (time in s) by group:";
+    for (unsigned int g=0; g<n_group; ++g)
+      pcout << " " << g << ":" << group_iters[g] << "(" << group_times[g] << ")";
+    pcout << std::endl;
+  }
+  if (log_enabled (log_debug))
+  {
+    pcout << "  HO linear iters (time in s) by direction:";
+    for (unsigned int i_dir=0; i_dir<n_dir; ++i_dir)
+      pcout << " " << i_dir << ":" << dir_iters[i_dir] << "(" << dir_times[i_dir] << ")";
+    pcout << std::endl;
+  }
+  if (n_failures>0)
+    radio ("  HO components failing to converge", n_failures);
+}
+
+template <int dim>
+void TransportBase<dim>::record_convergence_history (std::string iteration_type,
+                                                     unsigned int ct,
+                                                     double iteration_time,
+                                                     double err_phi,
+                                                     double spectral_radius,
+                                                     double err_k)
+{
+  // cumulative time only counts SI sweeps s.t. PI rows are not double counted
+  if (!convergence_out.is_open ())
+    return;
+  convergence_out << search_trial << "," << iteration_type << ","
+  << (iteration_type=="SI" ? current_pi_iter : ct) << ","
+  << ct << "," << iteration_time << "," << total_iteration_time << ","
+  << total_linear_iters << "," << err_phi << "," << spectral_radius << ",";
+  if (is_eigen_problem)
+    convergence_out << keff << "," << (iteration_type=="PI" ? err_k : 0.0);
+  else
+    convergence_out << ",";
+  convergence_out << std::endl;
+}
+
 template <int dim>
 void TransportBase<dim>::renormalize_sflx
 (std::vector<LA::MPI::Vector*> &target_sflxes)
@@ -667,6 +1480,7 @@ void TransportBase<dim>::renormalize_sflx
   AssertThrow (target_sflxes.size()==n_group,
                ExcMessage("vector of scalar fluxes must have a size of n_group"));
   double norm_factor = target_sflxes[0]->max ();
+  comm_ptr->record ("renormalize_sflx", "max reduction", 1, sizeof (double));
   for (unsigned int g=0; g<n_group; ++g)
     *target_sflxes[g] /= norm_factor;
 }
@@ -700,6 +1514,7 @@ double TransportBase<dim>::estimate_fiss_source (std::vector<Vector<double> > &p
     }
   }
   double global_fiss_source = Utilities::MPI::sum (fiss_source, mpi_communicator);
+  comm_ptr->record ("estimate_fiss_source", "allreduce (sum)", 1, sizeof (double));
   return global_fiss_source;
 }
 
@@ -724,6 +1539,7 @@ double TransportBase<dim>::estimate_phi_diff
     LA::MPI::Vector dif = *(phis_newer)[i];
     dif -= *(phis_older)[i];
     err = std::max (err, dif.l1_norm () / phis_newer[i]->l1_norm ());
+    comm_ptr->record ("estimate_phi_diff", "norm reduction", 2, 2 * sizeof (double));
   }
   return err;
 }
@@ -731,7 +1547,48 @@ double TransportBase<dim>::estimate_phi_diff
 template <int dim>
 void TransportBase<dim>::do_iterations ()
 {
-  sol_ptr->initialize_ho_preconditioners (vec_ho_sys, vec_ho_rhs);
+  Timer timer (mpi_communicator, true);
+  timer.start ();
+  bool is_setup_needed = (!are_operators_reused || are_preconditioners_stale);
+  are_preconditioners_stale = false;
+  if (is_setup_needed &&
+      (ho_linear_solver_name=="auto" || ho_preconditioner_name=="auto"))
+  {
+    sol_ptr->select_ho_solver (vec_ho_sys, vec_ho_rhs, pcout);
+    ho_linear_solver_name = sol_ptr->get_ho_linear_solver_name ();
+    ho_preconditioner_name = sol_ptr->get_ho_preconditioner_name ();
+    end_phase ("select HO solver", timer);
+  }
+  if (is_setup_needed)
+  {
+    sol_ptr->initialize_ho_preconditioners (vec_ho_sys, vec_ho_rhs);
+    // the refresh threshold is measured from here
+    if (pre_sigt.size ()==0)
+    {
+      pre_sigt = all_sigt;
+      is_group_pre_stale.assign (n_group, false);
+    }
+    for (unsigned int g=0; g<n_group; ++g)
+      if (is_group_pre_stale[g])
+      {
+        for (unsigned int m=0; m<n_material; ++m)
+          pre_sigt[m][g] = all_sigt[m][g];
+        is_group_pre_stale[g] = false;
+      }
+    // solver controls take the l1 norm of every right hand side
+    comm_ptr->record ("initialize HO preconditioners", "norm reduction",
+                      n_total_ho_vars, n_total_ho_vars * sizeof (double));
+    end_phase ("initialize HO preconditioners", timer);
+    if (do_print_memory_report)
+      report_memory ("after initialize_ho_preconditioners");
+  }
+  timer.restart ();
+  current_pi_iter = 0;
+  total_linear_iters = 0;
+  total_si_iters = 0;
+  total_iteration_time = 0.0;
+  // a critical search keeps the logs of all its trials open
+  bool are_logs_opened = open_iteration_logs ();
   if (is_eigen_problem)
   {
     if (do_nda)
@@ -754,6 +1611,430 @@ void TransportBase<dim>::do_iterations ()
       postprocess ();
     }
   }
+  if (are_logs_opened)
+    close_iteration_logs ();
+  end_phase ("iterations", timer);
+}
+
+template <int dim>
+bool TransportBase<dim>::open_iteration_logs ()
+{
+  if (Utilities::MPI::this_mpi_process(mpi_communicator)!=0 ||
+      telemetry_out.is_open () || convergence_out.is_open ())
+    return false;
+  if (telemetry_filename!="")
+  {
+    telemetry_out.open (telemetry_filename.c_str ());
+    telemetry_out << "search_trial,outer_iter,si_iter,component,direction,"
+    << "group,iterations,solve_time,final_residual,converged" << std::endl;
+  }
+  if (convergence_filename!="")
+  {
+    convergence_out.open (convergence_filename.c_str ());
+    convergence_out << "search_trial,type,outer_iter,iter,wall_time,"
+    << "cumulative_wall_time,cumulative_linear_iters,err_phi,spectral_radius,"
+    << "keff,err_k" << std::endl;
+  }
+  return telemetry_out.is_open () || convergence_out.is_open ();
+}
+
+template <int dim>
+void TransportBase<dim>::close_iteration_logs ()
+{
+  if (telemetry_out.is_open ())
+    telemetry_out.close ();
+  if (convergence_out.is_open ())
+    convergence_out.close ();
+}
+
+template <int dim>
+void TransportBase<dim>::critical_search ()
+{
+  AssertThrow (is_eigen_problem && !do_nda,
+               ExcMessage ("the critical search needs the power iteration without NDA"));
+  const double final_k_tol = err_k_tol;
+  const double final_phi_tol = err_phi_eigen_tol;
+  std::vector<std::vector<double> > deck_sigt = all_sigt;
+  std::vector<std::vector<std::vector<double> > > deck_sigs = all_sigs;
+  std::vector<std::vector<std::vector<double> > > deck_sigs_per_ster = all_sigs_per_ster;
+  // later trials assemble matrices the deck does not describe
+  cache_ptr->disable ();
+  
+  std::vector<double> scalings, keffs;
+  std::vector<unsigned int> pi_iters, si_iters;
+  double scaling = search_scalings[0];
+  double current_scaling = 1.0;
+  double k_err = 1.0;
+  bool is_converged = false;
+  // one file for all trials, told apart by the search_trial column
+  bool are_logs_opened = open_iteration_logs ();
+  for (unsigned int t=0; t<n_max_search_trials; ++t)
+  {
+    search_trial = t;
+    if (scaling!=current_scaling)
+    {
+      std::vector<std::vector<double> > old_sigt = all_sigt;
+      std::vector<std::vector<double> > old_inv_sigt = all_inv_sigt;
+      for (unsigned int m=0; m<n_material; ++m)
+        if (is_search_material[m])
+          for (unsigned int g=0; g<n_group; ++g)
+          {
+            all_sigt[m][g] = scaling * deck_sigt[m][g];
+            all_inv_sigt[m][g] = 1.0 / all_sigt[m][g];
+            for (unsigned int gin=0; gin<n_group; ++gin)
+            {
+              all_sigs[m][g][gin] = scaling * deck_sigs[m][g][gin];
+              all_sigs_per_ster[m][g][gin] = scaling * deck_sigs_per_ster[m][g][gin];
+            }
+          }
+      update_ho_operators (old_sigt, old_inv_sigt);
+      current_scaling = scaling;
+    }
+    // loose solves far from the root, the deck's tolerances close to it
+    double tol_ratio = (t==0 ? 1.0e3 :
+                        std::min (1.0e3, std::max (1.0, 0.1 * k_err / final_k_tol)));
+    err_k_tol = tol_ratio * final_k_tol;
+    err_phi_eigen_tol = tol_ratio * final_phi_tol;
+    // the first trial keeps the warm start of a batch case
+    is_warm_start = is_warm_start || t>0;
+    do_iterations ();
+    k_err = std::fabs (keff - 1.0);
+    scalings.push_back (scaling);
+    keffs.push_back (keff);
+    pi_iters.push_back (current_pi_iter);
+    si_iters.push_back (total_si_iters);
+    if (log_enabled (log_info))
+      pcout << "Critical search trial " << t << ", scaling: " << scaling
+      << ", k: " << keff << ", err_k tol: " << err_k_tol << std::endl;
+    if (k_err<search_tol && tol_ratio==1.0)
+    {
+      is_converged = true;
+      break;
+    }
+    if (t==0)
+      scaling = search_scalings[1];
+    else
+    {
+      if (keffs[t]==keffs[t-1])
+        break;
+      scaling = scalings[t] - ((keffs[t] - 1.0) * (scalings[t] - scalings[t-1]) /
+                               (keffs[t] - keffs[t-1]));
+      if (scaling<=0.0)
+        scaling = 0.5 * scalings[t];
+    }
+  }
+  if (are_logs_opened)
+    close_iteration_logs ();
+  search_trial = 0;
+  err_k_tol = final_k_tol;
+  err_phi_eigen_tol = final_phi_tol;
+  critical_scaling = scalings.back ();
+  
+  pcout << "Critical search" << std::endl;
+  pcout << std::setw(8) << std::left << "trial"
+  << std::setw(16) << std::right << "scaling"
+  << std::setw(16) << "keff"
+  << std::setw(10) << "PI iters"
+  << std::setw(10) << "SI iters" << std::endl;
+  for (unsigned int t=0; t<scalings.size(); ++t)
+    pcout << std::setw(8) << std::left << t
+    << std::setw(16) << std::right << std::fixed << std::setprecision(8) << scalings[t]
+    << std::setw(16) << keffs[t]
+    << std::setw(10) << pi_iters[t]
+    << std::setw(10) << si_iters[t] << std::endl;
+  pcout.get_stream().unsetf (std::ios_base::floatfield);
+  if (!is_converged)
+    pcout << "Critical search did not converge, the last trial is kept" << std::endl;
+  pcout << std::endl;
+}
+
+template <int dim>
+void TransportBase<dim>::solve_case ()
+{
+  is_rom_solved = false;
+  if (do_critical_search)
+    critical_search ();
+  else if (is_rom_built && rom_solve ())
+  {
+    is_rom_solved = true;
+    are_preconditioners_stale = are_preconditioners_stale || !are_operators_reused;
+  }
+  else
+  {
+    if (is_rom_built)
+      radio ("ROM error indicator above tolerance, solving in full", rom_indicator);
+    // a rejected reduced solution is still a good starting point
+    do_iterations ();
+    // the snapshots are taken once a next case needs them
+    is_snapshot_pending = do_rom;
+  }
+}
+
+template <int dim>
+void TransportBase<dim>::add_rom_snapshots ()
+{
+  if (rom_bases.size ()==0)
+    for (unsigned int g=0; g<n_group; ++g)
+      rom_bases.push_back (std_cxx11::shared_ptr<ReducedBasis>
+                           (new ReducedBasis (mpi_communicator)));
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+    rom_bases[get_component_group (k)]->add_snapshot (*vec_aflx[k]);
+  ++n_rom_cases;
+}
+
+template <int dim>
+void TransportBase<dim>::build_rom ()
+{
+  Timer timer (mpi_communicator, true);
+  timer.start ();
+  // the quadrature point values need every entry of the basis vectors, as
+  // the scalar fluxes in sflx_proc do
+  std::vector<std::vector<Vector<double> > > basis_proc (n_group);
+  for (unsigned int g=0; g<n_group; ++g)
+  {
+    rom_bases[g]->compress (rom_pod_tol);
+    basis_proc[g].resize (rom_bases[g]->size ());
+    for (unsigned int j=0; j<rom_bases[g]->size(); ++j)
+      basis_proc[g][j] = rom_bases[g]->get_vector (j);
+    if (log_enabled (log_info))
+      pcout << "ROM basis of group " << g << ": " << rom_bases[g]->size ()
+      << " modes from " << rom_bases[g]->n_snapshots () << " snapshots" << std::endl;
+  }
+  
+  rom_volume.resize (n_material, std::vector<Vector<double> > (n_group));
+  rom_mass.resize (n_material, std::vector<std::vector<FullMatrix<double> > >
+                   (n_group, std::vector<FullMatrix<double> > (n_group)));
+  for (unsigned int m=0; m<n_material; ++m)
+    for (unsigned int g=0; g<n_group; ++g)
+    {
+      rom_volume[m][g].reinit (basis_proc[g].size ());
+      for (unsigned int gin=0; gin<n_group; ++gin)
+        rom_mass[m][g][gin].reinit (basis_proc[g].size (), basis_proc[gin].size ());
+    }
+  std::vector<std::vector<std::vector<double> > > values (n_group);
+  for (unsigned int g=0; g<n_group; ++g)
+    values[g].resize (basis_proc[g].size (), std::vector<double> (n_q));
+  for (unsigned int ic=0; ic<local_cells.size(); ++ic)
+  {
+    typename DoFHandler<dim>::active_cell_iterator cell = local_cells[ic];
+    unsigned int mid = cell->material_id ();
+    fv->reinit (cell);
+    for (unsigned int g=0; g<n_group; ++g)
+      for (unsigned int j=0; j<basis_proc[g].size(); ++j)
+        fv->get_function_values (basis_proc[g][j], values[g][j]);
+    for (unsigned int g=0; g<n_group; ++g)
+      for (unsigned int i=0; i<basis_proc[g].size(); ++i)
+        for (unsigned int qi=0; qi<n_q; ++qi)
+        {
+          double v_jxw = values[g][i][qi] * fv->JxW (qi);
+          rom_volume[mid][g](i) += v_jxw;
+          for (unsigned int gin=0; gin<n_group; ++gin)
+            for (unsigned int j=0; j<basis_proc[gin].size(); ++j)
+              rom_mass[mid][g][gin](i,j) += v_jxw * values[gin][j][qi];
+        }
+  }
+  // one reduction for all integrals
+  std::vector<double> sums;
+  for (unsigned int pass=0; pass<2; ++pass)
+  {
+    unsigned int pos = 0;
+    for (unsigned int m=0; m<n_material; ++m)
+      for (unsigned int g=0; g<n_group; ++g)
+      {
+        for (unsigned int i=0; i<rom_volume[m][g].size(); ++i, ++pos)
+          if (pass==0)
+            sums.push_back (rom_volume[m][g](i));
+          else
+            rom_volume[m][g](i) = sums[pos];
+        for (unsigned int gin=0; gin<n_group; ++gin)
+          for (unsigned int i=0; i<rom_mass[m][g][gin].m(); ++i)
+            for (unsigned int j=0; j<rom_mass[m][g][gin].n(); ++j, ++pos)
+              if (pass==0)
+                sums.push_back (rom_mass[m][g][gin](i,j));
+              else
+                rom_mass[m][g][gin](i,j) = sums[pos];
+      }
+    if (pass==0)
+      MPI_Allreduce (MPI_IN_PLACE, &sums[0], sums.size (), MPI_DOUBLE, MPI_SUM,
+                     mpi_communicator);
+  }
+  comm_ptr->record ("build ROM", "allreduce (sum)", 1, sums.size () * sizeof (double));
+  is_rom_built = true;
+  end_phase ("build ROM", timer);
+}
+
+template <int dim>
+void TransportBase<dim>::rom_group_rhs (unsigned int g,
+                                        std::vector<Vector<double> > &c,
+                                        std::vector<Vector<double> > &c_prev_gen,
+                                        Vector<double> &rhs)
+{
+  // the projections of the sources generate_ho_fixed_source and
+  // generate_ho_rhs integrate
+  rhs.reinit (rom_bases[g]->size ());
+  Vector<double> tmp (rhs.size ());
+  for (unsigned int m=0; m<n_material; ++m)
+  {
+    if (!is_eigen_problem && all_q_per_ster[m][g]>1.0e-13)
+      rhs.add (all_q_per_ster[m][g], rom_volume[m][g]);
+    for (unsigned int gin=0; gin<n_group; ++gin)
+    {
+      if (all_sigs_per_ster[m][gin][g]>=1.0e-13)
+      {
+        rom_mass[m][g][gin].vmult (tmp, c[gin]);
+        rhs.add (all_sigs_per_ster[m][gin][g], tmp);
+      }
+      if (is_eigen_problem && is_material_fissile[m])
+      {
+        rom_mass[m][g][gin].vmult (tmp, c_prev_gen[gin]);
+        rhs.add (all_ksi_nusigf_per_ster[m][gin][g] / keff, tmp);
+      }
+    }
+  }
+}
+
+template <int dim>
+double TransportBase<dim>::rom_fiss_source (std::vector<Vector<double> > &c)
+{
+  double fiss_source = 0.0;
+  for (unsigned int m=0; m<n_material; ++m)
+    if (is_material_fissile[m])
+      for (unsigned int g=0; g<n_group; ++g)
+        fiss_source += all_nusigf[m][g] * (rom_volume[m][g] * c[g]);
+  return fiss_source;
+}
+
+template <int dim>
+unsigned int TransportBase<dim>::rom_source_iteration
+(std::vector<FullMatrix<double> > &inv_ar,
+ std::vector<Vector<double> > &c,
+ std::vector<Vector<double> > &c_prev_gen,
+ std::vector<Vector<double> > &a)
+{
+  // Jacobi in the groups, as the full source iteration
+  std::vector<Vector<double> > c_new (c);
+  Vector<double> rhs;
+  double err_phi = 1.0;
+  unsigned int ct = 0;
+  while (err_phi>err_phi_tol && ct<10000)
+  {
+    ct += 1;
+    double diff = 0.0, norm = 0.0;
+    for (unsigned int g=0; g<n_group; ++g)
+    {
+      rom_group_rhs (g, c, c_prev_gen, rhs);
+      c_new[g] = 0.0;
+      for (unsigned int i_dir=0; i_dir<n_dir; ++i_dir)
+      {
+        unsigned int k = get_component_index (i_dir, g);
+        inv_ar[k].vmult (a[k], rhs);
+        c_new[g].add (wi[i_dir], a[k]);
+      }
+      Vector<double> d (c_new[g]);
+      d -= c[g];
+      diff += d.norm_sqr ();
+      norm += c_new[g].norm_sqr ();
+    }
+    c = c_new;
+    err_phi = std::sqrt (diff / norm);
+  }
+  return ct;
+}
+
+template <int dim>
+bool TransportBase<dim>::rom_solve ()
+{
+  Timer timer (mpi_communicator, true);
+  timer.start ();
+  // V_g^T A_k V_g, once per operator and group
+  std::vector<FullMatrix<double> > inv_ar (n_total_ho_vars);
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+  {
+    unsigned int op = ho_operator_of[k];
+    unsigned int g = get_component_group (k);
+    if (op<k && get_component_group (op)==g)
+      inv_ar[k] = inv_ar[op];
+    else
+    {
+      rom_bases[g]->project (*vec_ho_sys[k], inv_ar[k]);
+      inv_ar[k].gauss_jordan ();
+      comm_ptr->record ("ROM solve", "allreduce (sum)", 1,
+                        inv_ar[k].m () * inv_ar[k].n () * sizeof (double));
+    }
+  }
+  
+  // the previous solution is the first guess
+  std::vector<Vector<double> > c (n_group), c_prev_gen;
+  std::vector<Vector<double> > a (n_total_ho_vars);
+  for (unsigned int g=0; g<n_group; ++g)
+    rom_bases[g]->project (*vec_ho_sflx[g], c[g]);
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+    a[k].reinit (rom_bases[get_component_group (k)]->size ());
+  c_prev_gen = c;
+  n_rom_iters = 0;
+  if (is_eigen_problem)
+  {
+    double fiss_source = rom_fiss_source (c);
+    double err_k = 1.0, err_phi = 1.0;
+    while ((err_k>err_k_tol || err_phi>err_phi_eigen_tol) && n_rom_iters<100000)
+    {
+      c_prev_gen = c;
+      n_rom_iters += rom_source_iteration (inv_ar, c, c_prev_gen, a);
+      double fiss_source_prev_gen = fiss_source;
+      double keff_prev_gen = keff;
+      fiss_source = rom_fiss_source (c);
+      keff = estimate_k (fiss_source, fiss_source_prev_gen, keff_prev_gen);
+      err_k = std::fabs (keff - keff_prev_gen) / keff;
+      double diff = 0.0, norm = 0.0;
+      for (unsigned int g=0; g<n_group; ++g)
+      {
+        Vector<double> d (c[g]);
+        d -= c_prev_gen[g];
+        diff += d.norm_sqr ();
+        norm += c[g].norm_sqr ();
+      }
+      err_phi = std::sqrt (diff / norm);
+    }
+  }
+  else
+    n_rom_iters = rom_source_iteration (inv_ar, c, c_prev_gen, a);
+  
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+    rom_bases[get_component_group (k)]->expand (a[k], *vec_aflx[k]);
+  generate_moments ();
+  if (is_eigen_problem)
+    fission_source = estimate_fiss_source (sflx_proc);
+  
+  // relative HO residual with the sources of the expanded solution; zero
+  // for the full solution
+  if (is_eigen_problem)
+  {
+    update_ho_moments_in_fiss ();
+    scale_fiss_transfer_matrices ();
+  }
+  generate_ho_fixed_source ();
+  generate_ho_rhs ();
+  double residual_norm = 0.0, rhs_norm = 0.0;
+  LA::MPI::Vector residual (*vec_ho_rhs[0]);
+  for (unsigned int k=0; k<n_total_ho_vars; ++k)
+  {
+    vec_ho_sys[k]->vmult (residual, *vec_aflx[k]);
+    residual -= *vec_ho_rhs[k];
+    residual_norm += residual.norm_sqr ();
+    rhs_norm += vec_ho_rhs[k]->norm_sqr ();
+  }
+  comm_ptr->record ("ROM solve", "norm reduction", 2 * n_total_ho_vars,
+                    2 * n_total_ho_vars * sizeof (double));
+  rom_indicator = std::sqrt (residual_norm / rhs_norm);
+  if (log_enabled (log_info))
+  {
+    pcout << "ROM solve: " << n_rom_iters << " reduced SI iterations";
+    if (is_eigen_problem)
+      pcout << ", k: " << keff;
+    pcout << ", error indicator: " << rom_indicator << std::endl;
+  }
+  end_phase ("ROM solve", timer);
+  return rom_indicator<=rom_tol;
 }
 
 template <int dim>
@@ -801,6 +2082,8 @@ void TransportBase<dim>::output_results () const
 template <int dim>
 void TransportBase<dim>::run ()
 {
+  Timer timer (mpi_communicator, true);
+  timer.start ();
   radio ("making grid");
   msh_ptr->make_grid (triangulation);
   msh_ptr->get_relevant_cell_iterators (dof_handler,
@@ -809,11 +2092,108 @@ void TransportBase<dim>::run ()
                                         is_cell_at_bd,
                                         is_cell_at_ref_bd);
   //msh_ptr.reset ();
+  end_phase ("make grid", timer);
   setup_system ();
   report_system ();
+  end_phase ("setup system", timer);
+  if (do_print_memory_report)
+    report_memory ("after setup_system");
+  timer.restart ();
   assemble_ho_system ();
-  do_iterations ();
+  end_phase ("assemble HO system", timer);
+  if (do_print_memory_report)
+    report_memory ("after assemble_ho_system");
+  solve_case ();
+  // process peak RSS in this report is the high-water mark over iterations
+  if (do_print_memory_report)
+    report_memory ("after iterations");
+  hwc_ptr->print (pcout);
+  comm_ptr->print (pcout);
+  timer.restart ();
   output_results();
+  end_phase ("output results", timer);
+}
+
+template <int dim>
+void TransportBase<dim>::run_next_case (ParameterHandler &prm)
+{
+  Timer timer (mpi_communicator, true);
+  timer.start ();
+  // the caller made sure that everything but materials, sources and file
+  // names is the same as in the previous deck
+  def_ptr = std_cxx11::shared_ptr<ProblemDefinition>
+  (new ProblemDefinition(prm));
+  mat_ptr = std_cxx11::shared_ptr<MaterialProperties>
+  (new MaterialProperties(prm));
+  cache_ptr = std_cxx11::shared_ptr<OperatorCache>
+  (new OperatorCache(prm, mpi_communicator));
+  namebase = def_ptr->get_output_namebase ();
+  telemetry_filename = def_ptr->get_linear_solver_telemetry_filename ();
+  convergence_filename = def_ptr->get_convergence_history_filename ();
+  pre_refresh_threshold = prm.get_double ("HO preconditioner refresh threshold");
+  std::vector<std::vector<double> > old_sigt = all_sigt;
+  std::vector<std::vector<double> > old_inv_sigt = all_inv_sigt;
+  process_material_properties ();
+  phase_wall_times.clear ();
+  // vec_aflx still holds the fluxes of the previous full solve
+  if (is_snapshot_pending)
+  {
+    add_rom_snapshots ();
+    if (n_rom_cases>=n_rom_training)
+      build_rom ();
+    is_snapshot_pending = false;
+    timer.restart ();
+  }
+  is_warm_start = true;
+  // the operators only depend on sigma_t
+  are_operators_reused = (all_sigt==old_sigt);
+  if (are_operators_reused)
+    radio ("reusing HO operators and preconditioners");
+  else
+    update_ho_operators (old_sigt, old_inv_sigt);
+  end_phase ("assemble HO system", timer);
+  solve_case ();
+  timer.restart ();
+  output_results ();
+  end_phase ("output results", timer);
+}
+
+template <int dim>
+void TransportBase<dim>::end_phase (std::string phase_name, Timer &timer)
+{
+  timer.stop ();
+  phase_wall_times[phase_name] = timer.wall_time ();
+  timer.restart ();
+}
+
+template <int dim>
+std::map<std::string, double> TransportBase<dim>::get_run_summary ()
+{
+  std::map<std::string, double> summary;
+  for (std::map<std::string, double>::iterator it=phase_wall_times.begin ();
+       it!=phase_wall_times.end (); ++it)
+    summary["time: " + it->first] = it->second;
+  summary["HO linear iterations"] = total_linear_iters;
+  summary["SI iterations"] = total_si_iters;
+  summary["operators reused"] = are_operators_reused;
+  if (do_critical_search)
+    summary["critical scaling"] = critical_scaling;
+  summary["ROM solve"] = is_rom_solved;
+  if (is_rom_solved)
+  {
+    summary["ROM error indicator"] = rom_indicator;
+    summary["SI iterations"] = n_rom_iters;
+    summary["HO linear iterations"] = 0;
+  }
+  if (is_eigen_problem)
+    summary["keff"] = keff;
+  for (unsigned int g=0; g<n_group; ++g)
+  {
+    std::ostringstream os;
+    os << "phi l1 norm (group " << g << ")";
+    summary[os.str ()] = vec_ho_sflx[g]->l1_norm ();
+  }
+  return summary;
 }
 
 // wrapper functions used to retrieve info from various Hash tables
@@ -848,16 +2228,27 @@ unsigned int TransportBase<dim>::get_reflective_direction_index
                                                     incident_angle_index)];
 }
 
-//functions used to cout information for diagonose or just simply cout
+template <int dim>
+bool TransportBase<dim>::log_enabled (LogLevel level)
+{
+  return level<=log_level;
+}
+
+//functions used to cout information for diagonose or just simply cout;
+//all of them print at info level
 template <int dim>
 void TransportBase<dim>::radio (std::string str)
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << str << std::endl;
 }
 
 template <int dim>
 void TransportBase<dim>::radio (std::string str1, std::string str2)
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << str1 << ": " << str2 << std::endl;
 }
 
@@ -865,6 +2256,8 @@ template <int dim>
 void TransportBase<dim>::radio (std::string str,
                                 double num)
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << str << ": " << num << std::endl;
 }
 
@@ -873,6 +2266,8 @@ void TransportBase<dim>::radio (std::string str1, unsigned int num1,
                                 std::string str2, unsigned int num2,
                                 std::string str3, unsigned int num3)
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << str1 << ": " << num1 << ", ";
   pcout << str2 << ": " << num2 << ", ";
   pcout << str3 << ": " << num3 << std::endl;;
@@ -882,18 +2277,24 @@ template <int dim>
 void TransportBase<dim>::radio (std::string str,
                                 unsigned int num)
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << str << ": " << num << std::endl;
 }
 
 template <int dim>
 void TransportBase<dim>::radio (std::string str, bool boolean)
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << str << ": " << (boolean?"true":"false") << std::endl;
 }
 
 template <int dim>
 void TransportBase<dim>::radio ()
 {
+  if (!log_enabled (log_info))
+    return;
   pcout << "-------------------------------------" << std::endl << std::endl;
 }
 
@@ -18,6 +18,7 @@ namespace LA
 #include <deal.II/lac/petsc_precondition.h>
 #include <deal.II/lac/constraint_matrix.h>
 #include <deal.II/lac/sparsity_tools.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
 
 #include <deal.II/numerics/vector_tools.h>
 
@@ -31,6 +32,8 @@ namespace LA
 #include <deal.II/base/index_set.h>
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/thread_management.h>
 
 #include <deal.II/distributed/tria.h>
 
@@ -47,6 +50,12 @@ namespace LA
 
 #include "../common/problem_definition.h"
 #include "../common/preconditioner_solver.h"
+#include "../common/memory_report.h"
+#include "../common/hardware_counters.h"
+#include "../common/comm_ledger.h"
+#include "../common/operator_cache.h"
+#include "../common/off_process_exchange.h"
+#include "../common/reduced_basis.h"
 #include "../mesh/mesh_generator.h"
 #include "../material/material_properties.h"
 #include "../aqdata/aq_base.h"
@@ -57,10 +66,21 @@ template <int dim>
 class TransportBase
 {
 public:
-  TransportBase (ParameterHandler &prm);// : ProblemDefinition<dim> (prm){}
+  // ensembles run one instance per sub-communicator
+  TransportBase (ParameterHandler &prm,
+                 MPI_Comm mpi_communicator=MPI_COMM_WORLD);// : ProblemDefinition<dim> (prm){}
   virtual ~TransportBase ();
   
   void run ();
+  // batch mode: runs a deck that differs from the one of the previous run
+  // only in cross sections, sources and the output name. Mesh, DoFs,
+  // sparsity and cell caches are kept, operators and preconditioners too if
+  // sigma_t did not change, and the iterations start from the previous
+  // solution
+  void run_next_case (ParameterHandler &prm);
+  
+  // phase wall times, iteration counts and results of the latest run ()
+  std::map<std::string, double> get_run_summary ();
   
   virtual void pre_assemble_cell_matrices
   (const std_cxx11::shared_ptr<FEValues<dim> > fv,
@@ -106,26 +126,102 @@ public:
    FullMatrix<double> &vn_up,
    FullMatrix<double> &vn_un);
   
+  // coefficients that define the operator of component k: components with
+  // equal keys share one matrix and preconditioner. Unique per component
+  // unless overriden
+  virtual std::vector<double> get_ho_operator_key (unsigned int k);
+  
   virtual void generate_moments ();
   virtual void postprocess ();
   virtual void generate_ho_rhs ();
   virtual void generate_ho_fixed_source ();
+  // scattering source of group g per local cell from sflx_at_qp; runs on
+  // worker threads, so it must not touch PETSc objects or the shared FEValues
+  virtual void integrate_ho_group_source (unsigned int g,
+                                          std::vector<Vector<double> > &cell_rhses);
+  // adds the fixed source to the assembled source of group g and copies the
+  // result to the other directions
+  virtual void finish_ho_rhs (unsigned int g);
+  
+  // microbenchmarks drive the setup steps and kernels directly
+  template <int> friend class KernelBenchmark;
   
 private:
   void setup_system ();
   void generate_globally_refined_grid ();
   void report_system ();
   void print_angular_quad ();
+  void report_memory (std::string stage_name);
+  void estimate_comm_volumes ();
+  void end_phase (std::string phase_name, Timer &timer);
+  bool open_iteration_logs ();
+  void close_iteration_logs ();
+  void record_linear_solver_telemetry (unsigned int si_ct);
+  void record_convergence_history (std::string iteration_type,
+                                   unsigned int ct,
+                                   double iteration_time,
+                                   double err_phi,
+                                   double spectral_radius,
+                                   double err_k);
   
   // void setup_lo_system();
   void setup_boundary_ids ();
   void get_cell_mfps (unsigned int &material_id, double &cell_dimension,
                       std::vector<double> &local_mfps);
   void assemble_ho_volume_boundary ();
+  void fill_test_at_qp ();
   void assemble_ho_interface ();
+  void find_identical_operators ();
+  // one matrix per distinct operator, plus the exchanges sized for them
+  void allocate_ho_matrices ();
+  // brings the HO matrices up to date after sigma_t changed
+  void update_ho_operators (std::vector<std::vector<double> > &old_sigt,
+                            std::vector<std::vector<double> > &old_inv_sigt);
+  // secant search for the scaling of the search materials' sigma_t and
+  // sigma_s that makes keff 1; every trial starts from the previous one
+  void critical_search ();
+  // the critical search, a reduced solve or the full iterations; full solves
+  // feed the reduced-order model when it is enabled and a next case comes
+  void solve_case ();
+  // reduced-order model: the angular fluxes of every group are expanded in
+  // a POD basis of the fluxes of full solves, and the source iteration runs
+  // on the Galerkin projections of the HO operators
+  void add_rom_snapshots ();
+  // bases, and the integrals of basis functions and their products over
+  // every material, which is all the reduced sources need
+  void build_rom ();
+  // true if the HO residual of the expanded solution is within tolerance
+  bool rom_solve ();
+  unsigned int rom_source_iteration (std::vector<FullMatrix<double> > &inv_ar,
+                                     std::vector<Vector<double> > &c,
+                                     std::vector<Vector<double> > &c_prev_gen,
+                                     std::vector<Vector<double> > &a);
+  void rom_group_rhs (unsigned int g,
+                      std::vector<Vector<double> > &c,
+                      std::vector<Vector<double> > &c_prev_gen,
+                      Vector<double> &rhs);
+  double rom_fiss_source (std::vector<Vector<double> > &c);
+  // adds new minus old local matrices of the cells and faces touching
+  // materials whose sigma_t changed; returns false without doing anything
+  // if so many cells changed that a full assembly is cheaper
+  bool reassemble_changed_materials (std::vector<std::vector<double> > &old_sigt,
+                                     std::vector<std::vector<double> > &old_inv_sigt);
   void assemble_ho_system ();
+  // assembly pipelined with the preconditioner setup: a worker thread
+  // integrates component k+1 while this thread adds component k to its
+  // matrix and sets up its preconditioner
+  void pipelined_setup ();
+  void integrate_ho_component (unsigned int k,
+                               std::vector<std::vector<FullMatrix<double> > > &streaming_at_qp,
+                               std::vector<FullMatrix<double> > &collision_at_qp,
+                               std::vector<FullMatrix<double> > &cell_matrices,
+                               std::vector<FullMatrix<double> > &face_matrices);
+  void add_ho_component (unsigned int k,
+                         std::vector<FullMatrix<double> > &cell_matrices,
+                         std::vector<FullMatrix<double> > &face_matrices);
   void do_iterations ();
   void process_input ();
+  void process_material_properties ();
   void initialize_material_id ();
   void initialize_dealii_objects ();
   void initialize_system_matrices_vectors ();
@@ -141,6 +237,11 @@ private:
   void update_ho_moments_in_fiss ();
   void update_fiss_source_keff ();
   void source_iteration ();
+  // one sweep as a task graph: the sources of all groups are integrated on
+  // worker threads while the main thread solves and accumulates the moments
+  // of the groups whose source is done
+  void pipelined_sweep ();
+  void generate_group_moments (unsigned int g);
   void scale_fiss_transfer_matrices ();
   void renormalize_sflx (std::vector<LA::MPI::Vector*> &target_sflxes);
   void NDA_PI ();
@@ -159,6 +260,9 @@ private:
   std_cxx11::shared_ptr<MaterialProperties> mat_ptr;
   std_cxx11::shared_ptr<AQBase<dim> > aqd_ptr;
   std_cxx11::shared_ptr<PreconditionerSolver> sol_ptr;
+  std_cxx11::shared_ptr<MemoryReport> mem_ptr;
+  std_cxx11::shared_ptr<HardwareCounters> hwc_ptr;
+  std_cxx11::shared_ptr<OperatorCache> cache_ptr;
   std_cxx11::shared_ptr<SolverControl> gcn;
   
   std::string transport_model_name;
@@ -167,6 +271,55 @@ private:
   std::string discretization;
   std::string namebase;
   std::string aq_name;
+  std::string telemetry_filename;
+  std::string convergence_filename;
+  std::string comm_ledger_filename;
+  
+  std::ofstream telemetry_out;
+  std::ofstream convergence_out;
+  // trial of the critical search the logged rows belong to
+  unsigned int search_trial;
+  
+  unsigned int n_threads;
+  
+  // batch mode state
+  bool are_operators_reused;
+  bool is_warm_start;
+  double pre_refresh_threshold;
+  // sigma_t the HO preconditioners of every group were set up with, and the
+  // groups whose preconditioners are set up again in the next setup
+  std::vector<std::vector<double> > pre_sigt;
+  std::vector<bool> is_group_pre_stale;
+  
+  // critical search
+  bool do_critical_search;
+  std::vector<bool> is_search_material;
+  std::vector<double> search_scalings;
+  double search_tol;
+  unsigned int n_max_search_trials;
+  double critical_scaling;
+  
+  // reduced-order model
+  bool do_rom;
+  unsigned int n_rom_training;
+  unsigned int n_rom_cases;
+  double rom_tol;
+  double rom_pod_tol;
+  bool is_rom_built;
+  bool is_rom_solved;
+  // the fluxes of the latest full solve are still to be added as snapshots
+  bool is_snapshot_pending;
+  double rom_indicator;
+  unsigned int n_rom_iters;
+  // preconditioners lag behind matrices that only reduced solves used
+  bool are_preconditioners_stale;
+  // per group, for the directions of the group alike
+  std::vector<std_cxx11::shared_ptr<ReducedBasis> > rom_bases;
+  // integrals over every material m: of basis function j of group g,
+  // rom_volume[m][g](j), and of products of basis functions of groups g and
+  // gin, rom_mass[m][g][gin](i,j)
+  std::vector<std::vector<Vector<double> > > rom_volume;
+  std::vector<std::vector<std::vector<FullMatrix<double> > > > rom_mass;
   
 protected:
   unsigned int get_component_index (unsigned int incident_angle_index, unsigned int g);
@@ -176,6 +329,10 @@ protected:
   unsigned int get_reflective_direction_index (unsigned int boundary_id,
                                                unsigned int incident_angle_index);
   
+  // values of the latest scalar fluxes at the quadrature points of every
+  // local cell, shared by the sources of all groups
+  void evaluate_sflx_at_qp ();
+  
   void radio (std::string str);
   void radio (std::string str1, std::string str2);
   void radio (std::string str1, unsigned int num1,
@@ -186,6 +343,10 @@ protected:
   void radio (std::string str, bool boolean);
   void radio ();
   
+  // depends on the level only, so it is the same on every process and can
+  // guard diagnostics that need collective operations
+  bool log_enabled (LogLevel level);
+  
   std::vector<typename DoFHandler<dim>::active_cell_iterator> local_cells;
   std::vector<typename DoFHandler<dim>::active_cell_iterator> ref_bd_cells;
   std::vector<bool> is_cell_at_bd;
@@ -208,9 +369,10 @@ protected:
   IndexSet local_dofs;
   IndexSet relevant_dofs;
   
-  const double err_k_tol;
+  // the eigenvalue tolerances are loosened for early critical search trials
+  double err_k_tol;
   const double err_phi_tol;
-  const double err_phi_eigen_tol;
+  double err_phi_eigen_tol;
   
   double ssor_omega;
   double keff;
@@ -219,12 +381,17 @@ protected:
   double c_penalty;
   double fission_source;
   double fission_source_prev_gen;
+  double total_iteration_time;
   
   bool is_eigen_problem;
   bool do_nda;
   bool have_reflective_bc;
   bool is_explicit_reflective;
   bool do_print_sn_quad;
+  bool do_print_memory_report;
+  bool do_hardware_counters;
+  
+  LogLevel log_level;
   
   unsigned int n_q;
   unsigned int n_qf;
@@ -237,14 +404,40 @@ protected:
   unsigned int n_material;
   unsigned int p_order;
   unsigned int global_refinements;
+  unsigned int current_pi_iter;
+  unsigned int total_linear_iters;
+  unsigned int total_si_iters;
   
   std::vector<unsigned int> linear_iters;
   
+  // communication ledger and the bytes this process sends per compress of
+  // a fixed source vector and per halo exchange in a matrix-vector product
+  std_cxx11::shared_ptr<CommLedger> comm_ptr;
+  double vector_stash_bytes;
+  double halo_bytes;
+  
+  // batched off-process entries of the HO matrices (volume/boundary and
+  // interface loops) and of the scattering source per group
+  std_cxx11::shared_ptr<OffProcessExchange> sys_exchange_ptr;
+  std_cxx11::shared_ptr<OffProcessExchange> interface_exchange_ptr;
+  std_cxx11::shared_ptr<OffProcessExchange> rhs_exchange_ptr;
+  // the same for a single group or component, used by the pipelined sweep
+  // and setup
+  std_cxx11::shared_ptr<OffProcessExchange> group_rhs_exchange_ptr;
+  std_cxx11::shared_ptr<OffProcessExchange> component_exchange_ptr;
+  
   std::vector<types::global_dof_index> local_dof_indices;
   std::vector<types::global_dof_index> neigh_dof_indices;
   
-  // HO system
+  // HO system; components with identical operators point to the same
+  // matrix, vec_ho_unique_sys holds each matrix once, in the order of
+  // ho_unique_operators, the component that owns it
   std::vector<LA::MPI::SparseMatrix*> vec_ho_sys;
+  std::vector<LA::MPI::SparseMatrix*> vec_ho_unique_sys;
+  std::vector<unsigned int> ho_unique_operators;
+  std::vector<unsigned int> ho_operator_of;
+  // kept so that matrices can be allocated again, e.g. in batch mode
+  DynamicSparsityPattern dsp;
   std::vector<LA::MPI::Vector*> vec_aflx;
   std::vector<LA::MPI::Vector*> vec_ho_rhs;
   std::vector<LA::MPI::Vector*> vec_ho_fixed_rhs;
@@ -276,6 +469,8 @@ protected:
   std::vector<std::vector<std::vector<double> > > scat_scaled_fiss_transfer_per_ster;
   std::vector<std::vector<std::vector<double> > > scaled_fiss_transfer;
   std::vector<FullMatrix<double> > vec_test_at_qp;
+  // per local cell, group and quadrature point
+  std::vector<std::vector<std::vector<double> > > sflx_at_qp;
   std::vector<Vector<double> > sflx_proc;
   std::vector<Vector<double> > sflx_proc_prev_gen;
   std::vector<Vector<double> > lo_sflx_proc;
@@ -283,6 +478,7 @@ protected:
   std::map<std::pair<unsigned int, unsigned int>, unsigned int> component_index;
   std::map<std::pair<unsigned int, unsigned int>, unsigned int> reflective_direction_index;
   std::map<std::vector<unsigned int>, unsigned int> relative_position_to_id;
+  std::map<std::string, double> phase_wall_times;
   std::unordered_map<unsigned int, std::pair<unsigned int, unsigned int> > inverse_component_index;
   std::unordered_map<unsigned int, bool> is_reflective_bc;
   std::unordered_map<unsigned int, bool> is_material_fissile;